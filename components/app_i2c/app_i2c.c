@@ -2,6 +2,8 @@
 
 #include "string.h"
 
+#include "esp_timer.h"
+
 #include "esp_log.h"
 static const char *TAG = "APP_I2C";
 
@@ -37,10 +39,13 @@ esp_err_t app_i2c_create(
 
 	ESP_LOGV(TAG, "Loading I2C configuration parameters.");
 	i2c->args = malloc(sizeof(app_i2c_config_args_t));
-	i2c->args->scl           = args->scl;
-	i2c->args->sda           = args->sda;
-	i2c->args->scl_period_ms = args->scl_period_ms;
-	i2c->args->op_delay_ms   = args->op_delay_ms;
+	i2c->args->scl            = args->scl;
+	i2c->args->sda            = args->sda;
+	i2c->args->scl_period_ms  = args->scl_period_ms;
+	i2c->args->op_delay_ms    = args->op_delay_ms;
+	i2c->args->half_period_us = args->half_period_us;
+
+	memset(&(i2c->stats), 0, sizeof(app_i2c_stats_t));
 
 	return ESP_OK;
 }
@@ -93,6 +98,19 @@ esp_err_t app_i2c_release(
 
 /* I2C basic logic methods */
 
+static esp_err_t app_i2c_stop(
+		app_i2c_handle_t *i2c );
+
+static void app_i2c_half_period(
+		app_i2c_handle_t *i2c )
+{
+	// Calibrated bus: busy-wait, tick-based sleeps only have 10 ms resolution
+	if (i2c->args->half_period_us)
+		app_i2c_ll_delay_us(i2c->args->half_period_us);
+	else
+		app_i2c_ll_sleep(i2c->args->op_delay_ms);
+}
+
 static esp_err_t app_i2c_wait_while_clock_stretching(
 		uint8_t  scl       ,
 		uint32_t period_ms )
@@ -128,7 +146,72 @@ static esp_err_t app_i2c_wait_while_clock_stretching(
 	}
 
 	ESP_LOGE(TAG, "Timeout while trying to detect SCL high waiting for clock.");
-	return ESP_FAIL;
+	return APP_I2C_ERR_TIMEOUT;
+}
+
+#define I2C_RECOVERY_PULSES 9
+
+/* A slave interrupted mid-byte holds SDA low until it has clocked out the
+ * rest of its byte: at most 9 clock pulses, then a STOP resets its logic. */
+static esp_err_t app_i2c_bus_recover(
+		app_i2c_handle_t *i2c )
+{
+	ESP_LOGW(TAG,
+		"SDA held low at START, recovering bus of I2C handle \"%.*s\".",
+		I2C_NAME_SIZE, i2c->name
+	);
+
+	esp_err_t ret;
+
+	int64_t start = esp_timer_get_time();
+
+	uint8_t level = 0;
+	uint8_t i;
+	for (i = 0; i < I2C_RECOVERY_PULSES; ++i)
+	{
+		// Set SCL low
+		ret = app_i2c_ll_SCL_out(i2c->args->scl);
+		if (ret != ESP_OK)
+			return ret;
+		app_i2c_half_period(i2c);
+
+		// Set SCL loose and wait for SCL high
+		ret = app_i2c_ll_SCL_in(i2c->args->scl);
+		if (ret != ESP_OK)
+			return ret;
+		ret = app_i2c_wait_while_clock_stretching(i2c->args->scl, i2c->args->scl_period_ms);
+		if (ret != ESP_OK)
+			return ret;
+		app_i2c_half_period(i2c);
+
+		app_i2c_ll_SDA_read(i2c->args->sda, &level);
+		if (level)
+			break;
+	}
+
+	// START + STOP to reset the slave state machines
+	ret = app_i2c_stop(i2c);
+	if (ret != ESP_OK)
+		return ret;
+	app_i2c_ll_SDA_read(i2c->args->sda, &level);
+
+	uint32_t elapsed_us = (uint32_t) (esp_timer_get_time() - start);
+	if (elapsed_us > i2c->stats.recovery_max_us)
+		i2c->stats.recovery_max_us = elapsed_us;
+	i2c->stats.recoveries++;
+
+	if (level == 0)
+	{
+		ESP_LOGE(TAG, "SDA still held low after bus recovery (%u us).", elapsed_us);
+		i2c->stats.recovery_failures++;
+		return APP_I2C_ERR_BUS_STUCK;
+	}
+
+	ESP_LOGI(TAG,
+		"Bus recovered after %d clock pulses (%u us).",
+		i < I2C_RECOVERY_PULSES ? i + 1 : I2C_RECOVERY_PULSES, elapsed_us
+	);
+	return ESP_OK;
 }
 
 static esp_err_t app_i2c_start(
@@ -151,17 +234,31 @@ static esp_err_t app_i2c_start(
 	if (ret != ESP_OK)
 		goto app_i2c_start_error;
 
+	// Set SDA loose: must read high on an idle bus.
+	ret = app_i2c_ll_SDA_in(i2c->args->sda);
+	if (ret != ESP_OK)
+		goto app_i2c_start_error;
+
+	uint8_t level;
+	app_i2c_ll_SDA_read(i2c->args->sda, &level);
+	if (level == 0)
+	{
+		ret = app_i2c_bus_recover(i2c);
+		if (ret != ESP_OK)
+			goto app_i2c_start_error;
+	}
+
 	// Set SDA low.
 	ret = app_i2c_ll_SDA_out(i2c->args->sda);
 	if (ret != ESP_OK)
 		goto app_i2c_start_error;
-	app_i2c_ll_sleep(i2c->args->op_delay_ms);
+	app_i2c_half_period(i2c);
 
 	// Set SCL low.
 	ret = app_i2c_ll_SCL_out(i2c->args->scl);
 	if (ret != ESP_OK)
 		goto app_i2c_start_error;
-	app_i2c_ll_sleep(i2c->args->op_delay_ms);
+	app_i2c_half_period(i2c);
 
 	return ESP_OK;
 
@@ -187,19 +284,19 @@ static esp_err_t app_i2c_stop(
 	ret = app_i2c_ll_SDA_out(i2c->args->sda);
 	if (ret != ESP_OK)
 		goto app_i2c_stop_error;
-	app_i2c_ll_sleep(i2c->args->op_delay_ms);
+	app_i2c_half_period(i2c);
 
 	// Set SCL loose (high)
 	ret = app_i2c_ll_SCL_in(i2c->args->scl);
 	if (ret != ESP_OK)
 		goto app_i2c_stop_error;
-	app_i2c_ll_sleep(i2c->args->op_delay_ms);
+	app_i2c_half_period(i2c);
 
 	// Set SDA high.
 	ret = app_i2c_ll_SDA_in(i2c->args->sda);
 	if (ret != ESP_OK)
 		goto app_i2c_stop_error;
-	app_i2c_ll_sleep(i2c->args->op_delay_ms);
+	app_i2c_half_period(i2c);
 
 	return ESP_OK;
 
@@ -241,16 +338,27 @@ static esp_err_t app_i2c_write_byte(
 			ret = app_i2c_ll_SDA_out(i2c->args->sda); // SDA low
 		if (ret != ESP_OK)
 			goto app_i2c_write_byte_error;
-		app_i2c_ll_sleep(i2c->args->op_delay_ms); // wait half period
+		app_i2c_half_period(i2c); // wait half period
 
 		// Set SCL loose
 		ret = app_i2c_ll_SCL_in(i2c->args->scl);
-		app_i2c_ll_sleep(i2c->args->op_delay_ms); // wait half period
+		app_i2c_half_period(i2c); // wait half period
 
 		// Wait for SCL high
 		ret = app_i2c_wait_while_clock_stretching(i2c->args->scl, i2c->args->scl_period_ms);
 		if (ret != ESP_OK)
 			goto app_i2c_write_byte_error;
+
+		// Released SDA must read high: otherwise another driver holds it
+		if ( (data >> i) & 0x01 )
+		{
+			app_i2c_ll_SDA_read(i2c->args->sda, &level);
+			if (level == 0)
+			{
+				ret = APP_I2C_ERR_ARBITRATION;
+				goto app_i2c_write_byte_error;
+			}
+		}
 	}
 
 	// Receive ACK //
@@ -263,7 +371,7 @@ static esp_err_t app_i2c_write_byte(
 	ret = app_i2c_ll_SDA_in(i2c->args->sda);
 	if (ret != ESP_OK)
 		goto app_i2c_write_byte_error;
-	app_i2c_ll_sleep(i2c->args->op_delay_ms); // wait half period
+	app_i2c_half_period(i2c); // wait half period
 
 	// Set SCL loose
 	ret = app_i2c_ll_SCL_in(i2c->args->scl);
@@ -284,8 +392,8 @@ static esp_err_t app_i2c_write_byte(
 	// Assert ACK
 	if (level != 0)
 	{
-		ESP_LOGE(TAG, "NACK received after I2C write byte.");
-		return ESP_FAIL;
+		ESP_LOGD(TAG, "NACK received after I2C write byte.");
+		return APP_I2C_ERR_NACK_DATA;
 	}
 
 	return ESP_OK;
@@ -323,7 +431,7 @@ static esp_err_t app_i2c_read_byte(
 	// Read byte //
 	for (i = 7; i >= 0; i--)
 	{
-		app_i2c_ll_sleep(i2c->args->op_delay_ms);
+		app_i2c_half_period(i2c);
 		
 		// Set SCL loose
 		ret = app_i2c_ll_SCL_in(i2c->args->scl);
@@ -352,13 +460,13 @@ static esp_err_t app_i2c_read_byte(
 		ret = app_i2c_ll_SDA_in(i2c->args->sda); // NACK (high)
 	if (ret != ESP_OK)
 		goto app_i2c_read_byte_error;
-	app_i2c_ll_sleep(i2c->args->op_delay_ms);
+	app_i2c_half_period(i2c);
 	
 	// Set SCL loose
 	ret = app_i2c_ll_SCL_in(i2c->args->scl);
 	if (ret != ESP_OK)
 		goto app_i2c_read_byte_error;
-	app_i2c_ll_sleep(i2c->args->op_delay_ms);
+	app_i2c_half_period(i2c);
 
 	// Wait for SCL high.
 	ret = app_i2c_wait_while_clock_stretching(i2c->args->scl, i2c->args->scl_period_ms);
@@ -391,6 +499,34 @@ app_i2c_read_byte_error:
 
 /* I2C read/write methods */
 
+static esp_err_t app_i2c_address_result(
+		esp_err_t ret )
+{
+	// A NACK on the address byte means no (ready) device
+	return ret == APP_I2C_ERR_NACK_DATA ? APP_I2C_ERR_NACK_ADDR : ret;
+}
+
+static void app_i2c_count_error(
+		app_i2c_handle_t *i2c ,
+		esp_err_t         ret )
+{
+	switch (ret)
+	{
+		case APP_I2C_ERR_NACK_ADDR:   i2c->stats.nack_addr++;   break;
+		case APP_I2C_ERR_NACK_DATA:   i2c->stats.nack_data++;   break;
+		case APP_I2C_ERR_TIMEOUT:     i2c->stats.timeout++;     break;
+		case APP_I2C_ERR_ARBITRATION: i2c->stats.arbitration++; break;
+		default: break;
+	}
+}
+
+void app_i2c_get_stats(
+		app_i2c_handle_t *i2c   ,
+		app_i2c_stats_t  *stats )
+{
+	*stats = i2c->stats;
+}
+
 esp_err_t app_i2c_write(
 		app_i2c_handle_t *i2c     ,
 		uint8_t           address ,
@@ -408,13 +544,15 @@ esp_err_t app_i2c_write(
 	
 	uint16_t i;
 
+	i2c->stats.transactions++;
+
 	ESP_LOGV(TAG, "Sending START condition.");
 	ret = app_i2c_start(i2c);
 	if (ret != ESP_OK)
 		goto app_i2c_write_error;
 
 	ESP_LOGV(TAG, "Writing device address.");
-	ret = app_i2c_write_byte(i2c, address << 1); // read byte 0
+	ret = app_i2c_address_result(app_i2c_write_byte(i2c, address << 1)); // read byte 0
 	if (ret != ESP_OK)
 		goto app_i2c_write_error;
 
@@ -436,9 +574,10 @@ esp_err_t app_i2c_write(
 
 app_i2c_write_error:
 	ESP_LOGE(TAG,
-		"Error writing with I2C handle \"%.*s\". Sending STOP condition.",
-		I2C_NAME_SIZE, i2c->name
+		"Error writing with I2C handle \"%.*s\" (0x%X). Sending STOP condition.",
+		I2C_NAME_SIZE, i2c->name, ret
 	);
+	app_i2c_count_error(i2c, ret);
 	app_i2c_stop(i2c);
 	return ret;
 }
@@ -458,13 +597,15 @@ esp_err_t app_i2c_read(
 
 	esp_err_t ret;
 
+	i2c->stats.transactions++;
+
 	ESP_LOGV(TAG, "Sending START condition.");
 	ret = app_i2c_start(i2c);
 	if (ret != ESP_OK)
 		goto app_i2c_read_error;
 	
 	ESP_LOGV(TAG, "Writing address device.");
-	ret = app_i2c_write_byte(i2c, (address << 1) | 1);
+	ret = app_i2c_address_result(app_i2c_write_byte(i2c, (address << 1) | 1));
 	if (ret != ESP_OK)
 		goto app_i2c_read_error;
 
@@ -491,9 +632,71 @@ esp_err_t app_i2c_read(
 
 app_i2c_read_error:
 	ESP_LOGE(TAG,
-		"Error reading with I2C handle \"%.*s\". Sending STOP condition.",
+		"Error reading with I2C handle \"%.*s\" (0x%X). Sending STOP condition.",
+		I2C_NAME_SIZE, i2c->name, ret
+	);
+	app_i2c_count_error(i2c, ret);
+	app_i2c_stop(i2c);
+	return ret;
+}
+
+#define I2C_SCAN_FIRST_ADDRESS 0x08
+#define I2C_SCAN_LAST_ADDRESS  0x77
+
+esp_err_t app_i2c_probe(
+		app_i2c_handle_t *i2c     ,
+		uint8_t           address )
+{
+	ESP_LOGD(TAG,
+		"Probing device address \"%d\" with I2C handle \"%.*s\".",
+		address,
 		I2C_NAME_SIZE, i2c->name
 	);
-	ret = app_i2c_stop(i2c);
+
+	esp_err_t ret;
+
+	i2c->stats.transactions++;
+
+	ret = app_i2c_start(i2c);
+	if (ret == ESP_OK)
+		ret = app_i2c_address_result(app_i2c_write_byte(i2c, address << 1));
+
+	// An absent device is an expected result here: not counted as error
+	if (ret != ESP_OK && ret != APP_I2C_ERR_NACK_ADDR)
+		app_i2c_count_error(i2c, ret);
+
+	app_i2c_stop(i2c);
 	return ret;
-}
\ No newline at end of file
+}
+
+esp_err_t app_i2c_scan(
+		app_i2c_handle_t *i2c   ,
+		uint8_t          *found ,
+		uint8_t           max   ,
+		uint8_t          *count )
+{
+	esp_err_t ret;
+
+	*count = 0;
+
+	uint8_t address;
+	for (address = I2C_SCAN_FIRST_ADDRESS; address <= I2C_SCAN_LAST_ADDRESS; ++address)
+	{
+		ret = app_i2c_probe(i2c, address);
+		if (ret == APP_I2C_ERR_NACK_ADDR)
+			continue;
+		if (ret != ESP_OK)
+			return ret;
+
+		ESP_LOGI(TAG,
+			"Device found at address 0x%02X with I2C handle \"%.*s\".",
+			address,
+			I2C_NAME_SIZE, i2c->name
+		);
+		if (*count < max)
+			found[*count] = address;
+		(*count)++;
+	}
+
+	return ESP_OK;
+}
@@ -0,0 +1,193 @@
+#include "app_i2c.h"
+
+#include "esp_log.h"
+static const char *TAG = "APP_I2C_CALIB";
+
+#include "nvs.h"
+
+#include "defines_log.h"
+#define LOG_LOCAL_LEVEL APP_I2C_LOG_LEVEL
+
+#define APP_I2C_CALIB_NVS_NAMESPACE  "app_i2c" // key: handle name
+
+#define APP_I2C_CALIB_READS      16 // clean reads required at each step
+#define APP_I2C_CALIB_MARGIN     2  // half period multiplier over last clean step
+#define APP_I2C_CALIB_MAX_WORDS  4
+
+// Half SCL periods tried, slowest first (~10 kHz to ~500 kHz plus GPIO overhead)
+static const uint32_t app_i2c_calib_steps_us[] = { 50, 25, 12, 8, 5, 3, 2, 1 };
+
+#define APP_I2C_CALIB_STEPS \
+	(sizeof(app_i2c_calib_steps_us) / sizeof(app_i2c_calib_steps_us[0]))
+
+#define APP_I2C_CALIB_MAX_US  (app_i2c_calib_steps_us[0] * APP_I2C_CALIB_MARGIN)
+
+
+/* Calibration */
+
+static esp_err_t app_i2c_calib_step(
+		app_i2c_handle_t      *i2c      ,
+		uint8_t                address  ,
+		uint8_t                crc_init ,
+		const app_i2c_cmd_t   *cmd      )
+{
+	esp_err_t ret;
+
+	uint16_t response[APP_I2C_CALIB_MAX_WORDS];
+
+	uint8_t i;
+	for (i = 0; i < APP_I2C_CALIB_READS; ++i)
+	{
+		ret = app_i2c_cmd_execute(i2c, address, crc_init, cmd, NULL, response);
+		if (ret != ESP_OK)
+			return ret;
+	}
+
+	return ESP_OK;
+}
+
+esp_err_t app_i2c_calibrate(
+		app_i2c_handle_t      *i2c            ,
+		uint8_t                address        ,
+		uint8_t                crc_init       ,
+		const app_i2c_cmd_t   *cmd            ,
+		uint32_t              *half_period_us )
+{
+	ESP_LOGD(TAG,
+		"Calibrating SCL clock of I2C handle \"%s\" with command '%s'.",
+		i2c->name, cmd->name
+	);
+
+	if (!(cmd->crc & APP_I2C_CRC_RESPONSE) ||
+		cmd->resp_words == 0 ||
+		cmd->resp_words > APP_I2C_CALIB_MAX_WORDS )
+	{
+		ESP_LOGE(TAG, "Calibration command '%s' has no CRC-protected response.", cmd->name);
+		return ESP_ERR_INVALID_ARG;
+	}
+
+	esp_err_t ret = ESP_OK;
+
+	// A failing step must fail fast: no retries
+	app_i2c_cmd_t probe = *cmd;
+	probe.retries   = 0;
+	probe.budget_ms = 0;
+
+	uint32_t        original = i2c->args->half_period_us;
+	app_i2c_stats_t stats    = i2c->stats;
+
+	uint32_t clean = 0;
+	uint8_t  i;
+	for (i = 0; i < APP_I2C_CALIB_STEPS; ++i)
+	{
+		i2c->args->half_period_us = app_i2c_calib_steps_us[i];
+
+		ret = app_i2c_calib_step(i2c, address, crc_init, &probe);
+		if (ret != ESP_OK)
+		{
+			ESP_LOGD(TAG,
+				"Half period %d us failed (0x%X).",
+				app_i2c_calib_steps_us[i], ret
+			);
+			break;
+		}
+
+		clean = app_i2c_calib_steps_us[i];
+	}
+
+	i2c->stats = stats;
+
+	if (clean == 0)
+	{
+		ESP_LOGE(TAG,
+			"Calibration of I2C handle \"%s\" failed at slowest step (0x%X).",
+			i2c->name, ret
+		);
+		i2c->args->half_period_us = original;
+		return ret;
+	}
+
+	i2c->args->half_period_us = clean * APP_I2C_CALIB_MARGIN;
+	ESP_LOGI(TAG,
+		"I2C handle \"%s\" calibrated: clean down to %d us, using %d us half period.",
+		i2c->name, clean, i2c->args->half_period_us
+	);
+
+	if (half_period_us != NULL)
+		*half_period_us = i2c->args->half_period_us;
+
+	// Not fatal: calibrated again on next boot
+	app_i2c_timing_store(i2c);
+
+	return ESP_OK;
+}
+
+
+/* NVS storage */
+
+esp_err_t app_i2c_timing_load(
+		app_i2c_handle_t *i2c )
+{
+	esp_err_t ret;
+	nvs_handle_t nvs;
+
+	ret = nvs_open(APP_I2C_CALIB_NVS_NAMESPACE, NVS_READONLY, &nvs);
+	if (ret == ESP_ERR_NVS_NOT_FOUND)
+		return ESP_ERR_NOT_FOUND; // Namespace not created yet
+	if (ret != ESP_OK)
+	{
+		ESP_LOGW(TAG, "Error opening NVS storage (%s).", esp_err_to_name(ret));
+		return ret;
+	}
+
+	uint32_t half_period_us;
+	ret = nvs_get_u32(nvs, i2c->name, &half_period_us);
+	nvs_close(nvs);
+
+	if (ret == ESP_ERR_NVS_NOT_FOUND)
+		return ESP_ERR_NOT_FOUND;
+	if (ret != ESP_OK)
+	{
+		ESP_LOGW(TAG, "Error reading stored I2C timing (%s).", esp_err_to_name(ret));
+		return ret;
+	}
+
+	// Out of the calibration range: stale or corrupted, calibrate again
+	if (half_period_us == 0 || half_period_us > APP_I2C_CALIB_MAX_US)
+	{
+		ESP_LOGW(TAG, "Stored I2C timing %d us discarded.", half_period_us);
+		return ESP_ERR_NOT_FOUND;
+	}
+
+	i2c->args->half_period_us = half_period_us;
+	ESP_LOGI(TAG,
+		"I2C handle \"%s\" using stored %d us half period.",
+		i2c->name, half_period_us
+	);
+
+	return ESP_OK;
+}
+
+esp_err_t app_i2c_timing_store(
+		app_i2c_handle_t *i2c )
+{
+	esp_err_t ret;
+	nvs_handle_t nvs;
+
+	ret = nvs_open(APP_I2C_CALIB_NVS_NAMESPACE, NVS_READWRITE, &nvs);
+	if (ret != ESP_OK)
+	{
+		ESP_LOGW(TAG, "Error opening NVS storage (%s).", esp_err_to_name(ret));
+		return ret;
+	}
+
+	ret = nvs_set_u32(nvs, i2c->name, i2c->args->half_period_us);
+	if (ret == ESP_OK)
+		ret = nvs_commit(nvs);
+	nvs_close(nvs);
+
+	if (ret != ESP_OK)
+		ESP_LOGW(TAG, "Error storing I2C timing (%s).", esp_err_to_name(ret));
+
+	return ret;
+}
@@ -0,0 +1,240 @@
+#include "app_i2c.h"
+
+#include "esp_log.h"
+static const char *TAG = "APP_I2C_CMD";
+
+#include "stdbool.h"
+
+#include "esp_timer.h"
+
+#include "defines_log.h"
+#define LOG_LOCAL_LEVEL APP_I2C_LOG_LEVEL
+
+#define APP_I2C_CRC8_POLY  0x31 // x^8 + x^5 + x^4 + 1
+
+#define APP_I2C_CMD_MAX_WORDS 4
+
+#define APP_I2C_CMD_OP_SEND  0x01
+#define APP_I2C_CMD_OP_WAIT  0x02
+#define APP_I2C_CMD_OP_READ  0x04
+
+
+/* CRC */
+
+uint8_t app_i2c_crc8(
+		uint8_t const *bytes ,
+		uint16_t       count ,
+		uint8_t        init  )
+{
+	uint8_t crc8 = init;
+	uint16_t i, j;
+	for (i = 0; i < count; ++i)
+	{
+		crc8 ^= bytes[i];
+		for (j = 0; j < 8; ++j)
+		{
+			if (crc8 & 0x80)
+				crc8 = (crc8 << 1) ^ APP_I2C_CRC8_POLY;
+			else
+				crc8 = (crc8 << 1);
+		}
+	}
+
+	return crc8;
+}
+
+
+
+
+
+/* Command engine */
+
+static esp_err_t app_i2c_cmd_send_once(
+		app_i2c_handle_t      *i2c      ,
+		uint8_t                address  ,
+		uint8_t                crc_init ,
+		const app_i2c_cmd_t   *cmd      ,
+		const uint16_t        *args     )
+{
+	if (cmd->arg_words > APP_I2C_CMD_MAX_WORDS)
+		return ESP_ERR_INVALID_ARG;
+
+	uint8_t  buf[2 + APP_I2C_CMD_MAX_WORDS * 3];
+	uint16_t count = 0;
+
+	// Opcode, MSB first
+	if (cmd->opcode_len == 2)
+		buf[count++] = (uint8_t) (cmd->opcode >> 8);
+	buf[count++] = (uint8_t) (cmd->opcode & 0x00FF);
+
+	// Arguments, MSB first, each optionally followed by its CRC
+	uint8_t j;
+	for (j = 0; j < cmd->arg_words; ++j)
+	{
+		uint8_t *word = &buf[count];
+		if (cmd->word_len == 2)
+			buf[count++] = (uint8_t) (args[j] >> 8);
+		buf[count++] = (uint8_t) (args[j] & 0x00FF);
+
+		if (cmd->crc & APP_I2C_CRC_ARGS)
+		{
+			buf[count] = app_i2c_crc8(word, cmd->word_len, crc_init);
+			count++;
+		}
+	}
+
+	esp_err_t ret;
+	ret = app_i2c_write(i2c, address, buf, count);
+	if (ret != ESP_OK)
+		ESP_LOGE(TAG, "Error with command '%s'.", cmd->name);
+
+	return ret;
+}
+
+static esp_err_t app_i2c_cmd_read_once(
+		app_i2c_handle_t      *i2c      ,
+		uint8_t                address  ,
+		uint8_t                crc_init ,
+		const app_i2c_cmd_t   *cmd      ,
+		uint16_t              *response )
+{
+	if (cmd->resp_words > APP_I2C_CMD_MAX_WORDS)
+		return ESP_ERR_INVALID_ARG;
+
+	uint8_t stride = cmd->word_len + ( (cmd->crc & APP_I2C_CRC_RESPONSE) ? 1 : 0 );
+	uint8_t buf[APP_I2C_CMD_MAX_WORDS * 3];
+
+	esp_err_t ret;
+	ret = app_i2c_read(i2c, address, buf, cmd->resp_words * stride);
+	if (ret != ESP_OK)
+	{
+		ESP_LOGE(TAG, "Error reading after command '%s'.", cmd->name);
+		return ret;
+	}
+
+	uint8_t crc8 = crc_init;
+	uint8_t j;
+	for (j = 0; j < cmd->resp_words; ++j)
+	{
+		uint8_t *word = buf + j * stride;
+
+		if (cmd->crc & APP_I2C_CRC_RESPONSE)
+		{
+			// Cumulative checksums cover every data byte read so far
+			if ( !(cmd->crc & APP_I2C_CRC_CUMULATIVE) )
+				crc8 = crc_init;
+
+			crc8 = app_i2c_crc8(word, cmd->word_len, crc8);
+			if (crc8 != word[cmd->word_len])
+			{
+				ESP_LOGE(TAG, "CRC mismatch in response to command '%s'.", cmd->name);
+				i2c->stats.crc++;
+				return ESP_ERR_INVALID_CRC;
+			}
+		}
+
+		response[j] = (cmd->word_len == 2)
+			? ( (uint16_t) word[0] << 8 ) | ( (uint16_t) word[1] )
+			: (uint16_t) word[0];
+	}
+
+	return ESP_OK;
+}
+
+static bool app_i2c_cmd_retriable(
+		esp_err_t ret )
+{
+	// Glitches: a stuck or missing clock (timeout) is not retried
+	return ret == APP_I2C_ERR_NACK_ADDR   ||
+	       ret == APP_I2C_ERR_NACK_DATA   ||
+	       ret == APP_I2C_ERR_ARBITRATION ||
+	       ret == ESP_ERR_INVALID_CRC     ;
+}
+
+static esp_err_t app_i2c_cmd_run(
+		app_i2c_handle_t      *i2c      ,
+		uint8_t                address  ,
+		uint8_t                crc_init ,
+		const app_i2c_cmd_t   *cmd      ,
+		const uint16_t        *args     ,
+		uint16_t              *response ,
+		uint8_t                ops      )
+{
+	esp_err_t ret;
+
+	int64_t start   = esp_timer_get_time();
+	uint8_t attempt = 0;
+	while (1)
+	{
+		ret = ESP_OK;
+		if (ops & APP_I2C_CMD_OP_SEND)
+			ret = app_i2c_cmd_send_once(i2c, address, crc_init, cmd, args);
+
+		if (ret == ESP_OK && (ops & APP_I2C_CMD_OP_WAIT) && cmd->wait_ms)
+			app_i2c_ll_sleep(cmd->wait_ms);
+
+		if (ret == ESP_OK && (ops & APP_I2C_CMD_OP_READ))
+			ret = app_i2c_cmd_read_once(i2c, address, crc_init, cmd, response);
+
+		if (ret == ESP_OK)
+		{
+			if (attempt)
+				i2c->stats.recovered++;
+			return ESP_OK;
+		}
+
+		int64_t elapsed_ms = (esp_timer_get_time() - start) / 1000;
+		if ( !app_i2c_cmd_retriable(ret) || attempt >= cmd->retries ||
+			elapsed_ms >= cmd->budget_ms )
+		{
+			i2c->stats.failed++;
+			return ret;
+		}
+
+		attempt++;
+		i2c->stats.retries++;
+		ESP_LOGW(TAG,
+			"Retrying command '%s' (error 0x%X, attempt %d).",
+			cmd->name, ret, attempt + 1
+		);
+	}
+}
+
+esp_err_t app_i2c_cmd_send(
+		app_i2c_handle_t      *i2c      ,
+		uint8_t                address  ,
+		uint8_t                crc_init ,
+		const app_i2c_cmd_t   *cmd      ,
+		const uint16_t        *args     )
+{
+	return app_i2c_cmd_run(i2c, address, crc_init, cmd, args, NULL,
+		APP_I2C_CMD_OP_SEND);
+}
+
+esp_err_t app_i2c_cmd_read(
+		app_i2c_handle_t      *i2c      ,
+		uint8_t                address  ,
+		uint8_t                crc_init ,
+		const app_i2c_cmd_t   *cmd      ,
+		uint16_t              *response )
+{
+	return app_i2c_cmd_run(i2c, address, crc_init, cmd, NULL, response,
+		APP_I2C_CMD_OP_READ);
+}
+
+esp_err_t app_i2c_cmd_execute(
+		app_i2c_handle_t      *i2c      ,
+		uint8_t                address  ,
+		uint8_t                crc_init ,
+		const app_i2c_cmd_t   *cmd      ,
+		const uint16_t        *args     ,
+		uint16_t              *response )
+{
+	ESP_LOGD(TAG, "Executing command '%s'.", cmd->name);
+
+	uint8_t ops = APP_I2C_CMD_OP_SEND | APP_I2C_CMD_OP_WAIT;
+	if (cmd->resp_words)
+		ops |= APP_I2C_CMD_OP_READ;
+
+	return app_i2c_cmd_run(i2c, address, crc_init, cmd, args, response, ops);
+}
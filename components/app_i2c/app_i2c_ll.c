@@ -4,6 +4,7 @@
 
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h" // delay
+#include "esp_rom_sys.h"    // busy-wait delay
 
 // LOG
 #include "esp_log.h"
@@ -256,3 +257,9 @@ void app_i2c_ll_sleep(
 
 	vTaskDelay( ms / portTICK_PERIOD_MS );
 }
+
+void app_i2c_ll_delay_us(
+		uint32_t us )
+{
+	esp_rom_delay_us(us);
+}
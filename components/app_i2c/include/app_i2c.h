@@ -3,6 +3,17 @@
 
 #include "esp_err.h"
 
+/// ERROR CODES ///
+
+/* Transaction errors, to tell a retriable glitch from a dead device. CRC
+ * mismatches in command responses return ESP_ERR_INVALID_CRC. */
+#define APP_I2C_ERR_BASE         0xA000
+#define APP_I2C_ERR_NACK_ADDR    (APP_I2C_ERR_BASE + 1) // No device ACK on address byte
+#define APP_I2C_ERR_NACK_DATA    (APP_I2C_ERR_BASE + 2) // No device ACK on data byte
+#define APP_I2C_ERR_TIMEOUT      (APP_I2C_ERR_BASE + 3) // SCL held low (clock stretching timeout)
+#define APP_I2C_ERR_ARBITRATION  (APP_I2C_ERR_BASE + 4) // SDA low while sending a high bit
+#define APP_I2C_ERR_BUS_STUCK    (APP_I2C_ERR_BASE + 5) // SDA held low after bus recovery
+
 /// LOW LEVEL METHODS ///
 
 /**
@@ -115,6 +126,14 @@ esp_err_t app_i2c_ll_SCL_read(
 void app_i2c_ll_sleep(
 		uint32_t ms );
 
+/**
+ * @brief Busy-waits for given time (no task switch, for sub-tick delays).
+ * 
+ * @param us time to wait in microseconds.
+ */
+void app_i2c_ll_delay_us(
+		uint32_t us );
+
 
 
 
@@ -124,20 +143,38 @@ void app_i2c_ll_sleep(
 typedef struct {
 	uint8_t   scl           ;
 	uint8_t   sda           ;
-	uint32_t  scl_period_ms ;
-	uint32_t  op_delay_ms   ; // half SCL period
+	uint32_t  scl_period_ms  ;
+	uint32_t  op_delay_ms    ; // half SCL period
+	uint32_t  half_period_us ; // calibrated half SCL period, 0 if none
 } app_i2c_config_args_t;
 
 typedef struct {
-	char                  *name ;
-	app_i2c_config_args_t *args ;
+	uint32_t transactions      ; // read/write transactions
+	uint32_t nack_addr         ;
+	uint32_t nack_data         ;
+	uint32_t crc               ;
+	uint32_t timeout           ;
+	uint32_t arbitration       ;
+	uint32_t retries           ; // command attempts after a retriable error
+	uint32_t recovered         ; // commands succeeded after retrying
+	uint32_t failed            ; // commands failed after the retry policy
+	uint32_t recoveries        ; // stuck SDA recoveries at START
+	uint32_t recovery_failures ; // SDA still low after recovery
+	uint32_t recovery_max_us   ; // longest recovery sequence
+} app_i2c_stats_t;
+
+typedef struct {
+	char                  *name  ;
+	app_i2c_config_args_t *args  ;
+	app_i2c_stats_t        stats ;
 } app_i2c_handle_t;
 
 /**
  * @brief Creates an I2C handle with given configuration.
  * 
  * Configuration options for SCL/SDA GPIO pins, SCL clock period and low level
- * op delay (should be period / 2).
+ * op delay (should be period / 2). A non-zero 'half_period_us' (see
+ * app_i2c_calibrate()) replaces the op delay with a busy-wait.
  * 
  * Memory allocation! Handle should be deleted after use. See app_i2c_delete().
  * 
@@ -190,6 +227,9 @@ esp_err_t app_i2c_release(
  * @brief Executes one write transaction on the I2C bus, sending a given number
  *        of bytes.
  * 
+ * If SDA is held low at START (interrupted transaction), the bus is recovered
+ * first with up to 9 SCL pulses and a STOP condition.
+ * 
  * Aborts app if I2C low-level error.
  * 
  * @param[in] i2c     handle for I2C operation.
@@ -198,6 +238,8 @@ esp_err_t app_i2c_release(
  * @param[in] count   number of bytes to read from the buffer and send to device.
  * 
  * @return ESP_OK on success.
+ * @return APP_I2C_ERR_NACK_ADDR, APP_I2C_ERR_NACK_DATA, APP_I2C_ERR_TIMEOUT,
+ *         APP_I2C_ERR_ARBITRATION or APP_I2C_ERR_BUS_STUCK on bus errors.
  * @return Error otherwise.
  */
 esp_err_t app_i2c_write(
@@ -218,6 +260,8 @@ esp_err_t app_i2c_write(
  * @param[in] count   number of bytes to read from the device into the buffer.
  * 
  * @return ESP_OK on success.
+ * @return APP_I2C_ERR_NACK_ADDR, APP_I2C_ERR_TIMEOUT, APP_I2C_ERR_ARBITRATION
+ *         or APP_I2C_ERR_BUS_STUCK on bus errors.
  * @return Error otherwise.
  */
 esp_err_t app_i2c_read(
@@ -226,4 +270,180 @@ esp_err_t app_i2c_read(
 		uint8_t          *data    ,
 		uint16_t          count   );
 
+/**
+ * @brief Checks whether a device answers at an address: START, address byte
+ *        (write) and ACK check, then STOP. No data is transferred.
+ * 
+ * @param[in] i2c     handle for I2C operation.
+ * @param[in] address 7-bit I2C address for device.
+ * 
+ * @return ESP_OK if the device acknowledged its address.
+ * @return APP_I2C_ERR_NACK_ADDR if no device answered.
+ * @return The bus error otherwise.
+ */
+esp_err_t app_i2c_probe(
+		app_i2c_handle_t *i2c     ,
+		uint8_t           address );
+
+/**
+ * @brief Probes every non-reserved 7-bit address (0x08 - 0x77) of a bus.
+ * 
+ * @param[in]  i2c    handle for I2C operation.
+ * @param[out] found  buffer for the addresses that answered.
+ * @param[in]  max    size of the 'found' buffer.
+ * @param[out] count  number of addresses that answered (may exceed 'max').
+ * 
+ * @return ESP_OK on success, the bus error if the scan was interrupted.
+ */
+esp_err_t app_i2c_scan(
+		app_i2c_handle_t *i2c   ,
+		uint8_t          *found ,
+		uint8_t           max   ,
+		uint8_t          *count );
+
+/**
+ * @brief Copies the transaction and retry counters of an I2C handle.
+ * 
+ * @param[in]  i2c    handle for I2C operation.
+ * @param[out] stats  counters since the handle creation.
+ */
+void app_i2c_get_stats(
+		app_i2c_handle_t *i2c   ,
+		app_i2c_stats_t  *stats );
+
+
+
+
+
+/// COMMAND DESCRIPTORS ///
+
+#define APP_I2C_CRC_NONE       0x00
+#define APP_I2C_CRC_ARGS       0x01 // CRC8 after each argument word
+#define APP_I2C_CRC_RESPONSE   0x02 // CRC8 after each response word
+#define APP_I2C_CRC_BOTH       (APP_I2C_CRC_ARGS | APP_I2C_CRC_RESPONSE)
+#define APP_I2C_CRC_CUMULATIVE 0x04 // response CRC8 runs over all previous words
+
+/**
+ * Device command description: the opcode is sent MSB first, followed by the
+ * argument words; after 'wait_ms' the response words are read. Words are
+ * 'word_len' bytes wide (1 or 2), MSB first, each optionally followed by a
+ * CRC8 (polynomial 0x31, device-specific init value).
+ * 
+ * Retry policy: on a NACK, CRC or arbitration error the command is attempted
+ * again, up to 'retries' times, while less than 'budget_ms' have passed since
+ * the first attempt. Timeouts are not retried.
+ */
+typedef struct {
+	const char *name       ;
+	uint16_t    opcode     ;
+	uint8_t     opcode_len ; // 1 or 2 bytes
+	uint8_t     word_len   ; // 1 or 2 bytes
+	uint8_t     arg_words  ; // up to 4
+	uint16_t    wait_ms    ;
+	uint8_t     resp_words ; // up to 4
+	uint8_t     crc        ; // APP_I2C_CRC_* flags
+	uint8_t     retries    ;
+	uint16_t    budget_ms  ;
+} app_i2c_cmd_t;
+
+/**
+ * @brief Computes a CRC8 checksum (polynomial 0x31, no final XOR).
+ */
+uint8_t app_i2c_crc8(
+		uint8_t const *bytes ,
+		uint16_t       count ,
+		uint8_t        init  );
+
+/**
+ * @brief Sends a described command with its argument words (may be NULL if
+ *        the command has none), applying its retry policy.
+ * 
+ * @return ESP_OK on success, the I2C error otherwise.
+ */
+esp_err_t app_i2c_cmd_send(
+		app_i2c_handle_t      *i2c      ,
+		uint8_t                address  ,
+		uint8_t                crc_init ,
+		const app_i2c_cmd_t   *cmd      ,
+		const uint16_t        *args     );
+
+/**
+ * @brief Reads the response words of a described command, previously sent
+ *        with app_i2c_cmd_send() at least 'wait_ms' before. Only the read is
+ *        retried.
+ * 
+ * @return ESP_OK on success.
+ * @return ESP_ERR_INVALID_CRC if a response word checksum does not match.
+ * @return The I2C error otherwise.
+ */
+esp_err_t app_i2c_cmd_read(
+		app_i2c_handle_t      *i2c      ,
+		uint8_t                address  ,
+		uint8_t                crc_init ,
+		const app_i2c_cmd_t   *cmd      ,
+		uint16_t              *response );
+
+/**
+ * @brief Sends a described command, waits for it to complete and reads its
+ *        response (if any). Retries repeat the whole sequence.
+ */
+esp_err_t app_i2c_cmd_execute(
+		app_i2c_handle_t      *i2c      ,
+		uint8_t                address  ,
+		uint8_t                crc_init ,
+		const app_i2c_cmd_t   *cmd      ,
+		const uint16_t        *args     ,
+		uint16_t              *response );
+
+
+
+
+
+/// BUS CALIBRATION ///
+
+/**
+ * @brief Finds the fastest reliable SCL clock for a device: the half period
+ *        is stepped down while a CRC-protected command keeps reading back
+ *        clean, then set to a safety margin (half that frequency) above the
+ *        first failing step. The result is applied to the handle and stored
+ *        in NVS (see app_i2c_timing_load()).
+ * 
+ *        Calibration traffic is not counted in the handle statistics.
+ * 
+ * @param[in]  i2c             handle for I2C operation.
+ * @param[in]  address         7-bit I2C address for device.
+ * @param[in]  crc_init        device CRC8 init value.
+ * @param[in]  cmd             command with CRC-protected response words.
+ * @param[out] half_period_us  selected half SCL period (may be NULL).
+ * 
+ * @return ESP_OK on success.
+ * @return ESP_ERR_INVALID_ARG if the command response is not CRC-protected.
+ * @return The I2C error if even the slowest step fails (timing unchanged).
+ */
+esp_err_t app_i2c_calibrate(
+		app_i2c_handle_t      *i2c            ,
+		uint8_t                address        ,
+		uint8_t                crc_init       ,
+		const app_i2c_cmd_t   *cmd            ,
+		uint32_t              *half_period_us );
+
+/**
+ * @brief Applies the calibrated SCL timing stored in NVS for the handle. The
+ *        handle name is the NVS key (up to 15 characters).
+ * 
+ * @return ESP_OK on success.
+ * @return ESP_ERR_NOT_FOUND if the handle was never calibrated.
+ * @return The NVS error otherwise.
+ */
+esp_err_t app_i2c_timing_load(
+		app_i2c_handle_t *i2c );
+
+/**
+ * @brief Stores the current calibrated SCL timing of the handle in NVS.
+ * 
+ * @return ESP_OK on success, the NVS error otherwise.
+ */
+esp_err_t app_i2c_timing_store(
+		app_i2c_handle_t *i2c );
+
 #endif
\ No newline at end of file
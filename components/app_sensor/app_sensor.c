@@ -1,31 +1,997 @@
-#include "app_sensor.h"
+#include "app_sensor_priv.h"
 
 #include "esp_log.h"
 static const char *TAG = "APP_SENSOR";
 
+#include "string.h"
+#include "stdlib.h"
+
+#include "esp_timer.h"
+#include "soc/cpu.h"
+
 #define APP_SENSOR_SGP30_MEASURE_PERIOD_MS 1000
-#define APP_SENSOR_SGP30_BASELINE_VALUE    0x0000
+#define APP_SENSOR_SGP30_MEASURE_BUDGET_MS 60
+
+#define APP_SENSOR_SGP30_EARLY_PHASE_MS      (12 * 3600 * 1000)
+#define APP_SENSOR_SGP30_BASELINE_PERIOD_MS  (3600 * 1000)
+#define APP_SENSOR_SGP30_BASELINE_PHASE_MS   700
+#define APP_SENSOR_SGP30_BASELINE_BUDGET_MS  40
+
+// Stored baseline: valid for one week (datasheet), written at most every 6 h
+#define APP_SENSOR_SGP30_BASELINE_MAX_AGE_S       (7 * 24 * 3600)
+#define APP_SENSOR_SGP30_BASELINE_STORE_PERIOD_MS (6 * 3600 * 1000)
+
+// Convergence: TVOC within max(band, 1/10 of average) for stable samples
+#define APP_SENSOR_SGP30_WARMUP_MS            15000
+#define APP_SENSOR_CONVERGENCE_BAND_PPB       10
+#define APP_SENSOR_CONVERGENCE_STABLE_SAMPLES 60
+
+#define APP_SENSOR_SI7021_MEASURE_PERIOD_MS  10000
+#define APP_SENSOR_SI7021_MEASURE_PHASE_MS   500
+#define APP_SENSOR_SI7021_MEASURE_BUDGET_MS  50 // Per step (bus transaction)
+
+#define APP_SENSOR_HUMIDITY_PHASE_MS   0
+#define APP_SENSOR_HUMIDITY_BUDGET_MS  40
+
+// Between the Si7021 (500 ms) and the baseline (700 ms) slots
+#define APP_SENSOR_HEATER_PHASE_MS     600
+#define APP_SENSOR_HEATER_BUDGET_MS    40 // Up to two register writes
+#define APP_SENSOR_HEATER_OFF_RETRY_MS 1000
+
+#define APP_SENSOR_HUMIDITY_DEAD_BAND   0x0010 // 1/16 g/m^3 (8.8 fixed-point)
+#define APP_SENSOR_HUMIDITY_REFRESH_MS  (10 * 60 * 1000)
 #define APP_SENSOR_SI7021_AVAILABLE 1
 
-#define APP_SENSOR_TASK_STACK_SIZE 2048
+#define APP_SENSOR_HISTORY_LENGTH 3600 // 1 hour at 1 Hz
+
+#define APP_SENSOR_TASK_STACK_SIZE   4096 // task state, NVS commits, logs, callbacks
+#define APP_SENSOR_TASK_STACK_MARGIN 512  // warn below this much free stack
 #define APP_SENSOR_TASK_PRIORITY   5
+#define APP_SENSOR_TASK_CORE       1 // APP_CPU: cycle counter is per core
+
+#define APP_SENSOR_TASK_EVENT_COMMAND 0x0001
+#define APP_SENSOR_TASK_EVENT_RELEASE 0x0002
+
+#define APP_SENSOR_DEADLINE_TOLERANCE_US 1000
+
+#define APP_SENSOR_COMMAND_TIMEOUT_MS 2000
+#define APP_SENSOR_MIN_PERIOD_MS      100
+
+static void app_sensor_publish(
+		app_sensor_handle_t *sensor ,
+		app_sensor_frame_t  *frame  )
+{
+	xQueueOverwrite(sensor->frame_queue, frame);
+
+	xSemaphoreTake(sensor->subscribers_mutex, portMAX_DELAY);
+
+	uint8_t i;
+	for (i = 0; i < APP_SENSOR_MAX_SUBSCRIBERS; ++i)
+	{
+		app_sensor_subscriber_t *sub = &(sensor->subscribers[i]);
+		if (sub->type == APP_SENSOR_SUBSCRIBER_NONE)
+			continue;
+
+		// Decimation: deliver every 'decimation' frames.
+		if (--(sub->countdown))
+			continue;
+		sub->countdown = sub->decimation;
+
+		switch (sub->type)
+		{
+			case APP_SENSOR_SUBSCRIBER_TASK:
+				xTaskNotifyGive(sub->task);
+				break;
+			case APP_SENSOR_SUBSCRIBER_QUEUE:
+				if (xQueueSend(sub->queue, frame, 0) != pdTRUE)
+					ESP_LOGD(TAG, "Subscriber %d queue full. Frame dropped.", i);
+				break;
+			case APP_SENSOR_SUBSCRIBER_CALLBACK:
+				sub->callback(frame, sub->arg);
+				break;
+			default:
+				break;
+		}
+	}
+
+	xSemaphoreGive(sensor->subscribers_mutex);
+}
+
+static void app_sensor_evaluate_alerts(
+		app_sensor_handle_t *sensor        ,
+		TickType_t           timestamp     ,
+		uint16_t             tvoc_ppb      ,
+		uint16_t             co2eq_ppm     ,
+		bool                 rh_valid      ,
+		int16_t              rh_centi      ,
+		int16_t              celsius_centi )
+{
+	int32_t values[APP_SENSOR_CHANNEL_COUNT];
+	uint32_t valid_mask = (1 << APP_SENSOR_CHANNEL_TVOC) | (1 << APP_SENSOR_CHANNEL_CO2EQ);
+
+	values[APP_SENSOR_CHANNEL_TVOC]  = tvoc_ppb;
+	values[APP_SENSOR_CHANNEL_CO2EQ] = co2eq_ppm;
+	if (rh_valid)
+	{
+		values[APP_SENSOR_CHANNEL_RH]          = rh_centi;
+		values[APP_SENSOR_CHANNEL_TEMPERATURE] = celsius_centi;
+		valid_mask |= (1 << APP_SENSOR_CHANNEL_RH) | (1 << APP_SENSOR_CHANNEL_TEMPERATURE);
+	}
+
+	app_sensor_alert_evaluate(
+		sensor->alert_rules    ,
+		sensor->alert_states   ,
+		sensor->alert_count    ,
+		values                 ,
+		valid_mask             ,
+		timestamp              ,
+		sensor->alert_callback ,
+		sensor->alert_arg      );
+}
+
+/* JOB SCHEDULER */
+
+typedef struct {
+	int64_t  period_us  ; // 0: aperiodic (run once when triggered)
+	int64_t  phase_us   ; // offset from the SGP30 grid
+	int64_t  budget_us  ; // worst-case run time
+	int64_t  deadline   ; // next slot in the job grid
+	int64_t  release    ; // actual run time (>= deadline if postponed)
+	uint8_t  step       ; // current step of the job state machine
+} app_sensor_job_t;
+
+#define APP_SENSOR_JOB_IDLE INT64_MAX
+
+/* Jobs are non-blocking state machines: each step issues a bus transaction
+ * and returns the time to wait before the next one (e.g. a conversion), or
+ * APP_SENSOR_JOB_DONE. Waits of all jobs overlap in the single task. */
+#define APP_SENSOR_JOB_DONE (-1)
+
+typedef struct {
+	app_sensor_job_t jobs[APP_SENSOR_JOB_COUNT] ;
+	bool             early_phase                ;
+	int64_t          early_phase_end_us         ; // Baseline valid from then on
+
+	uint16_t   tvoc_ppb             ;
+	uint16_t   co2eq_ppm            ;
+	uint32_t   sgp30_cycles         ;
+	uint32_t   si7021_cycles        ;
+	int64_t    sgp30_error_us       ; // Release error of current SGP30 sample
+	bool       rh_valid             ;
+	TickType_t rh_timestamp         ;
+	uint16_t   rh_code              ;
+	uint16_t   temperature_code     ;
+	uint8_t    rh_samples           ; // Oversampling of current measurement
+	uint32_t   rh_code_sum          ;
+	uint32_t   temperature_code_sum ;
+	int64_t    rh_masked_until      ; // Heater: readings discarded until then
+	bool       heater_on            ;
+	int16_t    rh_centi             ;
+	int16_t    celsius_centi        ;
+	uint16_t   rh_abs               ;
+
+	// Startup convergence tracking
+	app_sensor_status_t status        ;
+	int64_t             iaq_init_us   ;
+	uint32_t            tvoc_average  ; // 12.4 fixed-point moving average
+	uint16_t            stable_count  ;
+
+	// Last baseline written to NVS
+	bool     baseline_stored    ;
+	int64_t  baseline_stored_us ;
+
+	// Last absolute humidity written to the SGP30
+	bool     rh_abs_written_valid ;
+	uint16_t rh_abs_written       ;
+	int64_t  rh_abs_written_us    ;
+
+	// Device circuit breakers
+	app_sensor_health_t health ;
+
+	// Sample clock
+	esp_timer_handle_t  timer          ;
+	app_sensor_timing_t timing         ;
+	int64_t             timing_sum_us  ;
+	bool                stack_low      ;
+
+	app_sensor_frame_t frame ;
+} app_sensor_task_state_t;
+
+static void app_sensor_job_schedule(
+		app_sensor_job_t *job      ,
+		int64_t           deadline )
+{
+	job->deadline = deadline;
+	job->release  = deadline;
+}
+
+static void app_sensor_job_trigger(
+		app_sensor_job_t *job ,
+		int64_t           now )
+{
+	if (job->release == APP_SENSOR_JOB_IDLE)
+		app_sensor_job_schedule(job, now + job->phase_us);
+}
+
+static void app_sensor_job_done(
+		app_sensor_job_t *job ,
+		int64_t           now )
+{
+	if (job->period_us == 0)
+	{
+		app_sensor_job_schedule(job, APP_SENSOR_JOB_IDLE);
+		return;
+	}
+
+	// Keep the job grid, skipping slots already in the past.
+	int64_t deadline = job->deadline + job->period_us;
+	if (deadline <= now)
+		deadline += ( (now - deadline) / job->period_us + 1 ) * job->period_us;
+
+	app_sensor_job_schedule(job, deadline);
+}
+
+static app_sensor_job_id_t app_sensor_job_next(
+		app_sensor_task_state_t *state )
+{
+	// Ties resolve to the lowest id: SGP30 measurement first.
+	app_sensor_job_id_t next = APP_SENSOR_JOB_SGP30_IAQ;
+
+	uint8_t i;
+	for (i = 1; i < APP_SENSOR_JOB_COUNT; ++i)
+		if (state->jobs[i].release < state->jobs[next].release)
+			next = i;
+
+	return next;
+}
+
+static void app_sensor_release_callback(
+		void *arg )
+{
+	xTaskNotify((TaskHandle_t) arg, APP_SENSOR_TASK_EVENT_RELEASE, eSetBits);
+}
+
+static void app_sensor_timing_update(
+		app_sensor_handle_t     *sensor   ,
+		app_sensor_task_state_t *state    ,
+		int64_t                  error_us ,
+		uint32_t                 skipped  )
+{
+	app_sensor_timing_t *timing = &state->timing;
+
+	timing->samples++;
+	timing->last_error_us = (int32_t) error_us;
+	if (timing->last_error_us > timing->max_error_us)
+		timing->max_error_us = timing->last_error_us;
+	state->timing_sum_us  += error_us;
+	timing->mean_error_us = (int32_t) (state->timing_sum_us / timing->samples);
+
+	if (error_us > APP_SENSOR_DEADLINE_TOLERANCE_US)
+		timing->missed++;
+	timing->missed += skipped;
+
+	// High-water mark in bytes (ESP-IDF stacks are byte-sized)
+	timing->stack_free = (uint32_t) uxTaskGetStackHighWaterMark(NULL);
+	if (timing->stack_free < APP_SENSOR_TASK_STACK_MARGIN && !state->stack_low)
+	{
+		ESP_LOGW(TAG, "Sensor task stack low: %d bytes never used.", timing->stack_free);
+		state->stack_low = true;
+	}
+
+	xQueueOverwrite(sensor->timing_queue, timing);
+}
+
+static void app_sensor_baseline_schedule(
+		app_sensor_task_state_t *state ,
+		int64_t                  now   )
+{
+	app_sensor_job_t *job = &(state->jobs[APP_SENSOR_JOB_BASELINE]);
+
+	if (state->early_phase)
+	{
+		state->early_phase_end_us = now + (int64_t) APP_SENSOR_SGP30_EARLY_PHASE_MS * 1000;
+		app_sensor_job_schedule(job, state->early_phase_end_us);
+		return;
+	}
+
+	app_sensor_job_schedule(job, now + job->period_us);
+}
+
+static void app_sensor_baseline_persist(
+		app_sensor_task_state_t *state    ,
+		uint32_t                 baseline )
+{
+	// Rate-limited persistence to spare flash
+	int64_t now = esp_timer_get_time();
+	if (state->baseline_stored &&
+		now - state->baseline_stored_us < (int64_t) APP_SENSOR_SGP30_BASELINE_STORE_PERIOD_MS * 1000)
+		return;
+
+	if (app_sensor_baseline_store(baseline) == ESP_OK)
+	{
+		state->baseline_stored    = true;
+		state->baseline_stored_us = now;
+	}
+}
+
+static esp_err_t app_sensor_restore_baseline(
+		app_sensor_handle_t     *sensor ,
+		app_sensor_task_state_t *state  )
+{
+	uint32_t baseline;
+	if (xQueuePeek(sensor->baseline_queue, &baseline, 0) != pdTRUE)
+		return ESP_OK;
+
+	state->early_phase = false;
+	app_sensor_baseline_schedule(state, esp_timer_get_time());
+
+	return sgp30_set_iaq_baseline(sensor->sgp30, baseline);
+}
+
+static const char *app_sensor_device_names[APP_SENSOR_DEVICE_COUNT] = {
+	[APP_SENSOR_DEVICE_SGP30]  = "SGP30"  ,
+	[APP_SENSOR_DEVICE_SI7021] = "Si7021" };
+
+static bool app_sensor_device_allow(
+		app_sensor_handle_t     *sensor ,
+		app_sensor_task_state_t *state  ,
+		app_sensor_device_t      device )
+{
+	if (app_sensor_breaker_allow(&state->health.breaker[device], esp_timer_get_time()))
+		return true;
+
+	xQueueOverwrite(sensor->health_queue, &state->health);
+	return false;
+}
+
+static bool app_sensor_device_result(
+		app_sensor_handle_t     *sensor ,
+		app_sensor_task_state_t *state  ,
+		app_sensor_device_t      device ,
+		esp_err_t                ret    )
+{
+	app_sensor_breaker_t *breaker = &state->health.breaker[device];
+
+	// Publish only on changes: not on the common closed success
+	bool changed = (ret != ESP_OK || breaker->state != APP_SENSOR_BREAKER_CLOSED ||
+		breaker->consecutive);
+	bool recovered = app_sensor_breaker_result(breaker,
+		app_sensor_device_names[device], ret, esp_timer_get_time());
+	if (changed)
+		xQueueOverwrite(sensor->health_queue, &state->health);
+
+	return recovered;
+}
+
+static void app_sensor_startup(
+		app_sensor_handle_t     *sensor ,
+		app_sensor_task_state_t *state  )
+{
+	esp_err_t ret;
+
+	// Called right after 'iaq_init'
+	state->iaq_init_us  = esp_timer_get_time();
+	state->tvoc_average = 0;
+	state->stable_count = 0;
+
+	uint32_t baseline;
+	if (xQueuePeek(sensor->baseline_queue, &baseline, 0) == pdTRUE)
+	{
+		if (app_sensor_restore_baseline(sensor, state) != ESP_OK)
+			ESP_LOGW(TAG, "Error restoring SGP30 IAQ baseline.");
+	}
+	else if (sensor->startup == APP_SENSOR_STARTUP_FIRST)
+	{
+		// First-ever start: calibrated TVOC starting reference
+		uint16_t tvoc_baseline;
+		ret = sgp30_get_tvoc_inceptive_baseline_and_read(sensor->sgp30, &tvoc_baseline);
+		if (ret == ESP_OK)
+			ret = sgp30_set_tvoc_baseline(sensor->sgp30, tvoc_baseline);
+		if (ret == ESP_OK)
+			ESP_LOGI(TAG, "First start: TVOC inceptive baseline 0x%04X set.", tvoc_baseline);
+		else
+			ESP_LOGW(TAG, "Error setting SGP30 TVOC inceptive baseline.");
+	}
+
+	state->status.startup  = sensor->startup;
+	state->status.phase    = APP_SENSOR_PHASE_WARMUP;
+	state->status.ready_ms = 0;
+	xQueueOverwrite(sensor->status_queue, &state->status);
+}
+
+static void app_sensor_track_convergence(
+		app_sensor_handle_t     *sensor ,
+		app_sensor_task_state_t *state  )
+{
+	if (state->status.phase == APP_SENSOR_PHASE_READY)
+		return;
+
+	int64_t elapsed_us = esp_timer_get_time() - state->iaq_init_us;
+	if (elapsed_us < (int64_t) APP_SENSOR_SGP30_WARMUP_MS * 1000)
+		return;
+
+	if (state->status.phase == APP_SENSOR_PHASE_WARMUP)
+	{
+		state->status.phase = APP_SENSOR_PHASE_CONVERGING;
+		state->tvoc_average = (uint32_t) state->tvoc_ppb << 4;
+		xQueueOverwrite(sensor->status_queue, &state->status);
+		return;
+	}
+
+	// Exponential moving average, alpha = 1/8
+	int32_t sample  = (int32_t) state->tvoc_ppb << 4;
+	int32_t average = (int32_t) state->tvoc_average;
+	average += (sample - average) / 8;
+	state->tvoc_average = (uint32_t) average;
+
+	int32_t deviation = abs(sample - average) >> 4;
+	int32_t band      = (average >> 4) / 10;
+	if (band < APP_SENSOR_CONVERGENCE_BAND_PPB)
+		band = APP_SENSOR_CONVERGENCE_BAND_PPB;
+
+	if (deviation > band)
+	{
+		state->stable_count = 0;
+		return;
+	}
+
+	if (++(state->stable_count) < APP_SENSOR_CONVERGENCE_STABLE_SAMPLES)
+		return;
+
+	state->status.phase    = APP_SENSOR_PHASE_READY;
+	state->status.ready_ms = (uint32_t) (elapsed_us / 1000);
+	xQueueOverwrite(sensor->status_queue, &state->status);
+	ESP_LOGI(TAG, "SGP30 readings converged after %u s.", state->status.ready_ms / 1000);
+}
+
+static void app_sensor_sgp30_reinit(
+		app_sensor_handle_t     *sensor ,
+		app_sensor_task_state_t *state  )
+{
+	if (sgp30_iaq_init(sensor->sgp30) != ESP_OK)
+		ESP_LOGW(TAG, "Error when initializing SGP30 operation.");
+	app_sensor_startup(sensor, state);
+
+	// Humidity compensation is reset by 'iaq_init'
+	state->rh_abs_written_valid = false;
+	if (state->rh_valid)
+		app_sensor_job_trigger(&(state->jobs[APP_SENSOR_JOB_HUMIDITY]), esp_timer_get_time());
+}
+
+static int64_t app_sensor_job_sgp30_iaq(
+		app_sensor_handle_t     *sensor ,
+		app_sensor_task_state_t *state  ,
+		app_sensor_job_t        *job    )
+{
+	esp_err_t ret;
+	uint16_t  wait_ms;
+
+	uint32_t cycles = esp_cpu_get_ccount();
+	if (job->step == 0)
+	{
+		// Failing sensor: skip without bus time
+		if (!app_sensor_device_allow(sensor, state, APP_SENSOR_DEVICE_SGP30))
+		{
+			sensor->frames_suppressed++;
+			return APP_SENSOR_JOB_DONE;
+		}
+
+		// Start measurement, read after the conversion
+		ret = sgp30_measure_iaq_start(sensor->sgp30, &wait_ms);
+		state->sgp30_cycles = esp_cpu_get_ccount() - cycles;
+		if (ret == ESP_OK)
+			return (int64_t) wait_ms * 1000;
+	}
+	else
+	{
+		// Read air quality from SGP30
+		ret = sgp30_measure_iaq_read(
+			sensor->sgp30      ,
+			&state->tvoc_ppb   ,
+			&state->co2eq_ppm  );
+		state->sgp30_cycles += esp_cpu_get_ccount() - cycles;
+	}
+	app_sensor_profile_record(sensor, APP_SENSOR_PROF_SGP30_MEASURE, state->sgp30_cycles);
+
+	// Recovered after failing: its IAQ algorithm state may be lost
+	if (app_sensor_device_result(sensor, state, APP_SENSOR_DEVICE_SGP30, ret))
+		app_sensor_sgp30_reinit(sensor, state);
+
+	if (ret != ESP_OK)
+		ESP_LOGW(TAG, "Error while reading SGP30 measurements.");
+	else
+		app_sensor_track_convergence(sensor, state);
+	TickType_t timestamp = xTaskGetTickCount();
 
-#define APP_SENSOR_TASK_EVENT_DELETE 0x0001
+	// Suppress invalid cycles at the source
+	app_sensor_validity_t validity;
+	if (ret == ESP_ERR_INVALID_CRC)
+		validity = APP_SENSOR_VALIDITY_CRC_ERROR;
+	else if (ret != ESP_OK)
+		validity = APP_SENSOR_VALIDITY_STALE;
+	else if (state->status.phase == APP_SENSOR_PHASE_WARMUP)
+		validity = APP_SENSOR_VALIDITY_WARMUP;
+	else if (state->early_phase)
+		validity = APP_SENSOR_VALIDITY_EARLY;
+	else
+		validity = APP_SENSOR_VALIDITY_CALIBRATED;
+
+	if (validity != APP_SENSOR_VALIDITY_EARLY &&
+		validity != APP_SENSOR_VALIDITY_CALIBRATED)
+	{
+		sensor->frames_suppressed++;
+		return APP_SENSOR_JOB_DONE;
+	}
+
+	cycles = esp_cpu_get_ccount();
+
+	// Evaluate alert rules
+	if (sensor->alert_count)
+		app_sensor_evaluate_alerts(sensor, timestamp, state->tvoc_ppb,
+			state->co2eq_ppm, state->rh_valid, state->rh_centi, state->celsius_centi);
+
+	// Insert data to queues (no need to check errQUEUE_FULL)
+	xQueueOverwrite(sensor->tvoc_queue  , &state->tvoc_ppb  );
+	xQueueOverwrite(sensor->co2eq_queue , &state->co2eq_ppm );
+
+	// Publish frame to subscribers
+	app_sensor_frame_t *frame = &state->frame;
+	frame->sequence      += 1;
+	frame->timestamp      = timestamp;
+	frame->validity       = validity;
+	frame->tvoc_ppb       = state->tvoc_ppb;
+	frame->co2eq_ppm      = state->co2eq_ppm;
+	frame->rh_timestamp   = state->rh_timestamp;
+	frame->rh_centi       = state->rh_centi;
+	frame->celsius_centi  = state->celsius_centi;
+	app_sensor_publish(sensor, frame);
+
+	// Store raw codes, converted lazily by consumers
+	uint16_t raw[APP_SENSOR_CHANNEL_COUNT] = {
+		[APP_SENSOR_CHANNEL_TVOC]        = state->tvoc_ppb         ,
+		[APP_SENSOR_CHANNEL_CO2EQ]       = state->co2eq_ppm        ,
+		[APP_SENSOR_CHANNEL_RH]          = state->rh_code          ,
+		[APP_SENSOR_CHANNEL_TEMPERATURE] = state->temperature_code };
+	app_sensor_history_push(&(sensor->history), raw, frame->sequence);
+
+	app_sensor_profile_record(sensor, APP_SENSOR_PROF_PUBLISH,
+		esp_cpu_get_ccount() - cycles);
+
+	return APP_SENSOR_JOB_DONE;
+}
+
+static const struct {
+	si7021_resolution_t resolution ;
+	uint8_t             samples    ;
+} app_sensor_rh_profiles[APP_SENSOR_RH_PROFILE_COUNT] = {
+	[APP_SENSOR_RH_PROFILE_LOW_LATENCY]    = { SI7021_RESOLUTION_RH8_T12  , 1                          },
+	[APP_SENSOR_RH_PROFILE_BALANCED]       = { SI7021_RESOLUTION_RH12_T14 , 1                          },
+	[APP_SENSOR_RH_PROFILE_HIGH_PRECISION] = { SI7021_RESOLUTION_RH12_T14 , APP_SENSOR_RH_OVERSAMPLING },
+};
+
+static esp_err_t app_sensor_rh_profile_apply(
+		app_sensor_handle_t *sensor )
+{
+	// No bus transaction if the resolution does not change (register shadow)
+	return si7021_set_measurement_precision(
+		sensor->si7021                                        ,
+		app_sensor_rh_profiles[sensor->rh_profile].resolution );
+}
+
+static void app_sensor_si7021_complete(
+		app_sensor_handle_t     *sensor           ,
+		app_sensor_task_state_t *state            ,
+		esp_err_t                ret              ,
+		uint16_t                 rh_code          ,
+		uint16_t                 temperature_code );
+
+static int64_t app_sensor_job_si7021(
+		app_sensor_handle_t     *sensor ,
+		app_sensor_task_state_t *state  ,
+		app_sensor_job_t        *job    )
+{
+	esp_err_t ret;
+	uint16_t  wait_ms;
+	uint16_t  rh_code          = 0;
+	uint16_t  temperature_code = 0;
+
+	uint32_t cycles = esp_cpu_get_ccount();
+	if (job->step == 0)
+	{
+		// Heated sensor: keep the last unheated reading
+		if (esp_timer_get_time() < state->rh_masked_until)
+		{
+			sensor->rh_masked++;
+			return APP_SENSOR_JOB_DONE;
+		}
+
+		// Failing sensor: skip without waiting for bus timeouts
+		if (!app_sensor_device_allow(sensor, state, APP_SENSOR_DEVICE_SI7021))
+			return APP_SENSOR_JOB_DONE;
+
+		state->rh_samples           = 0;
+		state->rh_code_sum          = 0;
+		state->temperature_code_sum = 0;
+
+		// Conversion overlaps with the other jobs
+		ret = si7021_measure_raw_start(sensor->si7021, &wait_ms);
+		state->si7021_cycles = esp_cpu_get_ccount() - cycles;
+		if (ret == ESP_OK)
+			return (int64_t) wait_ms * 1000;
+	}
+	else
+	{
+		// Read humidity and temperature
+		ret = si7021_measure_raw_read(
+			sensor->si7021    ,
+			&rh_code          ,
+			&temperature_code );
+
+		// Oversampling: next conversion right away, average raw codes
+		bool more = false;
+		if (ret == ESP_OK)
+		{
+			state->rh_samples++;
+			state->rh_code_sum          += rh_code;
+			state->temperature_code_sum += temperature_code;
+
+			more = state->rh_samples < app_sensor_rh_profiles[sensor->rh_profile].samples;
+			if (more)
+				ret = si7021_measure_raw_start(sensor->si7021, &wait_ms);
+		}
+		state->si7021_cycles += esp_cpu_get_ccount() - cycles;
+
+		if (more && ret == ESP_OK)
+			return (int64_t) wait_ms * 1000;
+
+		if (ret == ESP_OK)
+		{
+			rh_code          = (state->rh_code_sum          + state->rh_samples / 2) / state->rh_samples;
+			temperature_code = (state->temperature_code_sum + state->rh_samples / 2) / state->rh_samples;
+		}
+	}
+	app_sensor_profile_record(sensor, APP_SENSOR_PROF_SI7021_READ, state->si7021_cycles);
+
+	app_sensor_si7021_complete(sensor, state, ret, rh_code, temperature_code);
+
+	return APP_SENSOR_JOB_DONE;
+}
+
+static void app_sensor_si7021_complete(
+		app_sensor_handle_t     *sensor           ,
+		app_sensor_task_state_t *state            ,
+		esp_err_t                ret              ,
+		uint16_t                 rh_code          ,
+		uint16_t                 temperature_code )
+{
+	app_sensor_device_result(sensor, state, APP_SENSOR_DEVICE_SI7021, ret);
+	if (ret != ESP_OK)
+	{
+		ESP_LOGW(TAG, "Error while reading Si7021 measurements");
+		return;
+	}
+
+	uint32_t cycles = esp_cpu_get_ccount();
+	state->rh_valid         = true;
+	state->rh_timestamp     = xTaskGetTickCount();
+	state->rh_code          = rh_code;
+	state->temperature_code = temperature_code;
+	state->rh_centi         = si7021_convert_rh_centi(rh_code);
+	state->celsius_centi    = si7021_convert_temperature_centi(temperature_code);
+
+	xQueueOverwrite(sensor->rh_queue      , &state->rh_centi      );
+	xQueueOverwrite(sensor->celsius_queue , &state->celsius_centi );
+
+	// Absolute humidty for SGP30
+	state->rh_abs = app_sensor_absolute_humidity(rh_code, temperature_code);
+	app_sensor_profile_record(sensor, APP_SENSOR_PROF_HUMIDITY_COMPUTE,
+		esp_cpu_get_ccount() - cycles);
+
+	// Humidity compensation only on change (or periodic refresh)
+	int64_t now = esp_timer_get_time();
+
+	uint16_t delta = state->rh_abs > state->rh_abs_written
+		? state->rh_abs - state->rh_abs_written
+		: state->rh_abs_written - state->rh_abs;
+	int64_t age_us = now - state->rh_abs_written_us;
+
+	if ( state->rh_abs_written_valid &&
+		delta <= sensor->humidity_dead_band &&
+		age_us < (int64_t) sensor->humidity_refresh_ms * 1000 )
+	{
+		sensor->humidity_skipped++;
+		return;
+	}
+
+	app_sensor_job_trigger(&(state->jobs[APP_SENSOR_JOB_HUMIDITY]), now);
+}
+
+static void app_sensor_job_humidity(
+		app_sensor_handle_t     *sensor ,
+		app_sensor_task_state_t *state  )
+{
+	esp_err_t ret;
+
+	// Retried on next Si7021 reading once the SGP30 works again
+	if (state->health.breaker[APP_SENSOR_DEVICE_SGP30].state != APP_SENSOR_BREAKER_CLOSED)
+	{
+		state->rh_abs_written_valid = false;
+		return;
+	}
+
+	// Set humidity in SGP30 sensor
+	uint32_t cycles = esp_cpu_get_ccount();
+	ret = sgp30_set_absolute_humidity(sensor->sgp30, state->rh_abs);
+	app_sensor_profile_record(sensor, APP_SENSOR_PROF_HUMIDITY_WRITE,
+		esp_cpu_get_ccount() - cycles);
+	if (ret != ESP_OK)
+	{
+		ESP_LOGW(TAG, "Error setting absolute humidity for SGP30");
+		state->rh_abs_written_valid = false;
+		return;
+	}
+
+	state->rh_abs_written_valid = true;
+	state->rh_abs_written       = state->rh_abs;
+	state->rh_abs_written_us    = esp_timer_get_time();
+	sensor->humidity_writes++;
+}
+
+static void app_sensor_job_baseline(
+		app_sensor_handle_t     *sensor ,
+		app_sensor_task_state_t *state  )
+{
+	esp_err_t ret;
+
+	// Baseline valid after the early phase, then retrieved hourly
+	if (state->early_phase)
+	{
+		if (esp_timer_get_time() < state->early_phase_end_us)
+			return;
 
-static uint16_t calculate_rh_abs_int(float rh_abs_f)
+		state->early_phase = false;
+	}
+
+	if (state->health.breaker[APP_SENSOR_DEVICE_SGP30].state != APP_SENSOR_BREAKER_CLOSED)
+		return;
+
+	uint32_t baseline;
+	uint32_t cycles = esp_cpu_get_ccount();
+	ret = sgp30_get_iaq_baseline_and_read(sensor->sgp30, &baseline);
+	app_sensor_profile_record(sensor, APP_SENSOR_PROF_BASELINE_FETCH,
+		esp_cpu_get_ccount() - cycles);
+	if (ret != ESP_OK)
+		return;
+	xQueueOverwrite(sensor->baseline_queue , &baseline);
+
+	app_sensor_baseline_persist(state, baseline);
+}
+
+static int64_t app_sensor_job_heater(
+		app_sensor_handle_t     *sensor ,
+		app_sensor_task_state_t *state  ,
+		app_sensor_job_t        *job    )
+{
+	esp_err_t ret;
+
+	app_sensor_heater_config_t *heater = &(sensor->heater);
+
+	/* The job period is the time to the next switch, keeping the duty cycle
+	 * on the job grid. */
+	if (state->heater_on)
+	{
+		ret = si7021_heater_disable(sensor->si7021);
+		app_sensor_device_result(sensor, state, APP_SENSOR_DEVICE_SI7021, ret);
+		if (ret != ESP_OK)
+		{
+			ESP_LOGW(TAG, "Error disabling Si7021 heater.");
+			job->period_us = (int64_t) APP_SENSOR_HEATER_OFF_RETRY_MS * 1000;
+			return APP_SENSOR_JOB_DONE;
+		}
+
+		state->heater_on       = false;
+		state->rh_masked_until = esp_timer_get_time() + (int64_t) heater->settle_ms * 1000;
+		job->period_us = (int64_t) (heater->period_ms - heater->on_ms) * 1000;
+		return APP_SENSOR_JOB_DONE;
+	}
+
+	job->period_us = (int64_t) heater->period_ms * 1000;
+
+	// Heat only when humid
+	if (heater->rh_threshold_centi &&
+		( !state->rh_valid || state->rh_centi < heater->rh_threshold_centi ))
+		return APP_SENSOR_JOB_DONE;
+
+	if (!app_sensor_device_allow(sensor, state, APP_SENSOR_DEVICE_SI7021))
+		return APP_SENSOR_JOB_DONE;
+
+	// No transaction for an unchanged current (register shadow)
+	ret = si7021_heater_set_current(sensor->si7021, heater->current);
+	if (ret == ESP_OK)
+		ret = si7021_heater_enable(sensor->si7021);
+	app_sensor_device_result(sensor, state, APP_SENSOR_DEVICE_SI7021, ret);
+	if (ret != ESP_OK)
+	{
+		ESP_LOGW(TAG, "Error enabling Si7021 heater.");
+		return APP_SENSOR_JOB_DONE;
+	}
+
+	state->heater_on       = true;
+	state->rh_masked_until = APP_SENSOR_JOB_IDLE;
+	job->period_us = (int64_t) heater->on_ms * 1000;
+	sensor->heater_pulses++;
+
+	return APP_SENSOR_JOB_DONE;
+}
+
+static int64_t app_sensor_job_run(
+		app_sensor_handle_t     *sensor ,
+		app_sensor_task_state_t *state  ,
+		app_sensor_job_id_t      id     )
 {
-	float intpart, fracpart;
-	fracpart = modff(rh_abs_f, &intpart);
+	app_sensor_job_t *job = &(state->jobs[id]);
 
-	uint8_t rh_int = 0xFF;
-	if (intpart < 255.0f)
-		rh_int = (uint8_t) intpart;
+	switch (id)
+	{
+		case APP_SENSOR_JOB_SGP30_IAQ:
+			return app_sensor_job_sgp30_iaq(sensor, state, job);
+		case APP_SENSOR_JOB_SI7021:
+			return app_sensor_job_si7021(sensor, state, job);
+		case APP_SENSOR_JOB_HUMIDITY:
+			app_sensor_job_humidity(sensor, state);
+			break;
+		case APP_SENSOR_JOB_BASELINE:
+			app_sensor_job_baseline(sensor, state);
+			break;
+		case APP_SENSOR_JOB_HEATER:
+			return app_sensor_job_heater(sensor, state, job);
+		default:
+			break;
+	}
 
-	uint8_t rh_frac = 0x00;
-	if (fracpart > 0.0f)
-		rh_frac = (uint8_t) (256.0f * fracpart);
+	return APP_SENSOR_JOB_DONE;
+}
 
-	return ( (uint16_t) rh_frac ) | ( ( (uint16_t) rh_int ) << 8 );
+static bool app_sensor_jobs_busy(
+		app_sensor_task_state_t *state )
+{
+	uint8_t i;
+	for (i = 0; i < APP_SENSOR_JOB_COUNT; ++i)
+		if (state->jobs[i].step)
+			return true;
+
+	return false;
+}
+
+static void app_sensor_jobs_init(
+		app_sensor_handle_t     *sensor ,
+		app_sensor_task_state_t *state  )
+{
+	int64_t now = esp_timer_get_time();
+
+	static const struct {
+		uint32_t period_ms ;
+		uint32_t phase_ms  ;
+		uint32_t budget_ms ;
+	} defaults[APP_SENSOR_JOB_COUNT] = {
+		[APP_SENSOR_JOB_SGP30_IAQ] = {
+			APP_SENSOR_SGP30_MEASURE_PERIOD_MS ,
+			0                                  ,
+			APP_SENSOR_SGP30_MEASURE_BUDGET_MS },
+		[APP_SENSOR_JOB_SI7021] = {
+			APP_SENSOR_SI7021_MEASURE_PERIOD_MS ,
+			APP_SENSOR_SI7021_MEASURE_PHASE_MS  ,
+			APP_SENSOR_SI7021_MEASURE_BUDGET_MS },
+		[APP_SENSOR_JOB_HUMIDITY] = {
+			0                               ,
+			APP_SENSOR_HUMIDITY_PHASE_MS    ,
+			APP_SENSOR_HUMIDITY_BUDGET_MS   },
+		[APP_SENSOR_JOB_BASELINE] = {
+			APP_SENSOR_SGP30_BASELINE_PERIOD_MS ,
+			APP_SENSOR_SGP30_BASELINE_PHASE_MS  ,
+			APP_SENSOR_SGP30_BASELINE_BUDGET_MS },
+		[APP_SENSOR_JOB_HEATER] = {
+			0                           ,
+			APP_SENSOR_HEATER_PHASE_MS  ,
+			APP_SENSOR_HEATER_BUDGET_MS },
+	};
+
+	uint8_t i;
+	for (i = 0; i < APP_SENSOR_JOB_COUNT; ++i)
+	{
+		app_sensor_job_t *job = &(state->jobs[i]);
+		job->period_us = (int64_t) defaults[i].period_ms * 1000;
+		job->phase_us  = (int64_t) defaults[i].phase_ms  * 1000;
+		job->budget_us = (int64_t) defaults[i].budget_ms * 1000;
+		job->step      = 0;
+		app_sensor_job_schedule(job, now + job->phase_us);
+	}
+
+	// Event driven: triggered on absolute humidity change
+	app_sensor_job_schedule(&(state->jobs[APP_SENSOR_JOB_HUMIDITY]), APP_SENSOR_JOB_IDLE);
+
+	if (sensor->si7021 == NULL)
+		app_sensor_job_schedule(&(state->jobs[APP_SENSOR_JOB_SI7021]), APP_SENSOR_JOB_IDLE);
+
+	// Period set by the heater job itself on each switch
+	if (sensor->si7021 == NULL || sensor->heater.period_ms == 0)
+		app_sensor_job_schedule(&(state->jobs[APP_SENSOR_JOB_HEATER]), APP_SENSOR_JOB_IDLE);
+	else
+		state->jobs[APP_SENSOR_JOB_HEATER].period_us = (int64_t) sensor->heater.period_ms * 1000;
+
+	app_sensor_baseline_schedule(state, now);
+}
+
+static esp_err_t app_sensor_process_command(
+		app_sensor_handle_t     *sensor ,
+		app_sensor_task_state_t *state  ,
+		app_sensor_cmd_t        *cmd    )
+{
+	esp_err_t ret = ESP_OK;
+
+	int64_t now = esp_timer_get_time();
+
+	switch (cmd->type)
+	{
+		case APP_SENSOR_CMD_SET_BASELINE:
+			ESP_LOGI(TAG, "Setting SGP30 IAQ baseline 0x%08X.", cmd->arg);
+			ret = sgp30_set_iaq_baseline(sensor->sgp30, cmd->arg);
+			if (ret != ESP_OK)
+				break;
+
+			xQueueOverwrite(sensor->baseline_queue, &(cmd->arg));
+			state->early_phase = false;
+			app_sensor_baseline_schedule(state, now);
+			app_sensor_baseline_persist(state, cmd->arg);
+			break;
+
+		case APP_SENSOR_CMD_SET_PERIOD:
+		{
+			if (cmd->job >= APP_SENSOR_JOB_COUNT)
+			{
+				ret = ESP_ERR_INVALID_ARG;
+				break;
+			}
+
+			ESP_LOGI(TAG, "Setting job %d period to %d ms.", cmd->job, cmd->arg);
+			if (cmd->job == APP_SENSOR_JOB_SGP30_IAQ &&
+				cmd->arg != APP_SENSOR_SGP30_MEASURE_PERIOD_MS)
+				ESP_LOGW(TAG, "SGP30 baseline compensation requires a 1 s period.");
+
+			app_sensor_job_t *job = &(state->jobs[cmd->job]);
+			job->period_us = (int64_t) cmd->arg * 1000;
+
+			// The early-phase release stands: the new period applies after it
+			if (cmd->job == APP_SENSOR_JOB_BASELINE && state->early_phase)
+				break;
+
+			if (job->period_us && job->release != APP_SENSOR_JOB_IDLE)
+				app_sensor_job_schedule(job, now + job->period_us);
+			break;
+		}
+
+		case APP_SENSOR_CMD_SELF_TEST:
+			// 'measure_test' must not run while in IAQ operation: re-init after.
+			ESP_LOGI(TAG, "Running SGP30 self-test.");
+			ret = sgp30_measure_test(sensor->sgp30);
+			if (ret != ESP_OK)
+				ESP_LOGW(TAG, "SGP30 self-test failed.");
+
+			app_sensor_sgp30_reinit(sensor, state);
+			break;
+
+		case APP_SENSOR_CMD_SET_RH_PROFILE:
+			ESP_LOGI(TAG, "Setting Si7021 measurement profile %d.", cmd->arg);
+			sensor->rh_profile = cmd->arg;
+			ret = app_sensor_rh_profile_apply(sensor);
+			break;
+
+		default:
+			ret = ESP_ERR_NOT_SUPPORTED;
+			break;
+	}
+
+	return ret;
 }
 
 static void app_sensor_task(
@@ -34,7 +1000,27 @@ static void app_sensor_task(
 	app_sensor_handle_t *sensor = (app_sensor_handle_t *)args;
 
 	esp_err_t ret;
-	BaseType_t xRet;
+
+	app_sensor_task_state_t state = {
+		.early_phase          = true  ,
+		.rh_valid             = false ,
+		.rh_timestamp         = 0     ,
+		.rh_code              = 0     ,
+		.temperature_code     = 0     ,
+		.rh_samples           = 0     ,
+		.rh_masked_until      = 0     ,
+		.heater_on            = false ,
+		.rh_centi             = 0     ,
+		.celsius_centi        = 0     ,
+		.rh_abs               = 0     ,
+		.rh_abs_written_valid = false ,
+		.baseline_stored      = false ,
+		.frame                = { 0 } };
+
+	uint8_t d;
+	for (d = 0; d < APP_SENSOR_DEVICE_COUNT; ++d)
+		app_sensor_breaker_init(&state.health.breaker[d]);
+	xQueueOverwrite(sensor->health_queue, &state.health);
 
 	// Initialize SGP30 sensor
 	ESP_LOGI(TAG, "Initializing SGP30 air quality sensor.");
@@ -42,110 +1028,128 @@ static void app_sensor_task(
 	if (ret != ESP_OK)
 		ESP_LOGW(TAG, "Error when initializing SGP30 operation.");
 
-	// Check if available baseline
-	bool early_phase = true;
-	uint32_t baseline = 0x0000;
-	xRet = xQueuePeek(sensor->baseline_queue, &baseline, 0);
-	if (xRet == pdTRUE)
-	{
-		early_phase = false;
-		sgp30_set_iaq_baseline(sensor->sgp30, baseline);
-	}
+	if (sensor->si7021 != NULL && app_sensor_rh_profile_apply(sensor) != ESP_OK)
+		ESP_LOGW(TAG, "Error setting Si7021 measurement resolution.");
+
+	// Heater left on by a previous run (no transaction if off)
+	if (sensor->si7021 != NULL && si7021_heater_disable(sensor->si7021) != ESP_OK)
+		ESP_LOGW(TAG, "Error disabling Si7021 heater.");
+
+	app_sensor_jobs_init(sensor, &state);
+
+	// Restore baseline or apply the first start TVOC inceptive baseline
+	app_sensor_startup(sensor, &state);
 
 	/* MEASUREMENT LOOP */
 
-	uint16_t tvoc_ppb;
-	uint16_t co2eq_ppm;
+	uint32_t ulNotifiedValue;
 
-	float rh_percent;
-	float celsius;
-	float rh_abs_f;
-	uint16_t rh_abs;
+	app_sensor_cmd_t    cmd;
+	app_sensor_job_id_t id;
+	app_sensor_job_t   *job;
+	app_sensor_job_t   *sgp30_job  = &(state.jobs[APP_SENSOR_JOB_SGP30_IAQ]);
+	app_sensor_job_t   *si7021_job = &(state.jobs[APP_SENSOR_JOB_SI7021]);
 
-	uint32_t ulNotifiedValue;
+	// One-shot hardware timer, armed at the next job release
+	esp_timer_create_args_t timer_args = {
+		.callback        = app_sensor_release_callback ,
+		.arg             = xTaskGetCurrentTaskHandle() ,
+		.dispatch_method = ESP_TIMER_TASK              ,
+		.name            = "App sensor: release"       };
+	ret = esp_timer_create(&timer_args, &state.timer);
+	if (ret != ESP_OK)
+		ESP_LOGE(TAG, "Error creating sample clock timer.");
+
+	bool command_pending = false;
 
-	TickType_t period = APP_SENSOR_SGP30_MEASURE_PERIOD_MS / portTICK_PERIOD_MS;
-	TickType_t timestamp = xTaskGetTickCount() - period;
-	uint16_t secs = 0;
+	int64_t now;
 	while (1)
 	{
-		if (sensor->si7021)
+		// Commands only between job sequences (device state machines idle)
+		if (command_pending && !app_sensor_jobs_busy(&state))
 		{
-			// Read humidity and temperature
-			ret = si7021_measure_and_read_converted(
-				sensor->si7021 ,
-				&rh_percent    ,
-				&celsius       );
-			if (ret != ESP_OK)
-				ESP_LOGW(TAG, "Error while reading Si7021 measurements");
-			else
+			command_pending = false;
+			while (xQueueReceive(sensor->command_queue, &cmd, 0) == pdTRUE)
 			{
-				// Calculate absolute humidty for SGP30
-				rh_abs_f = exp( 17.62f * celsius / (243.12f + celsius) );
-				rh_abs_f = (rh_percent / 100.0f) * 6.112f * rh_abs_f / (273.15f + celsius);
-				rh_abs_f = 216.7f * rh_abs_f;
-
-				// Set humidity in SGP30 sensor
-				rh_abs = calculate_rh_abs_int(rh_abs_f);
-				ret = sgp30_set_absolute_humidity(sensor->sgp30, rh_abs);
-				if (ret != ESP_OK)
-					ESP_LOGW(TAG, "Error setting absolute humidity for SGP30");
+				if (cmd.type == APP_SENSOR_CMD_STOP)
+				{
+					if (state.heater_on && si7021_heater_disable(sensor->si7021) != ESP_OK)
+						ESP_LOGW(TAG, "Error disabling Si7021 heater.");
+
+					esp_timer_stop(state.timer);
+					esp_timer_delete(state.timer);
+					sensor->task = NULL; // for external check
+					sensor->command_result        = ESP_OK;
+					sensor->command_done_sequence = cmd.sequence;
+					xSemaphoreGive(sensor->command_done);
+					vTaskDelete(NULL);
+				}
+
+				sensor->command_result        = app_sensor_process_command(sensor, &state, &cmd);
+				sensor->command_done_sequence = cmd.sequence;
+				xSemaphoreGive(sensor->command_done);
 			}
 		}
 
-		// Read air quality from SGP30
-		vTaskDelayUntil(&timestamp, period);
-		ret = sgp30_measure_iaq_and_read(
-			sensor->sgp30 ,
-			&tvoc_ppb     ,
-			&co2eq_ppm    );
-		if (ret != ESP_OK)
-			ESP_LOGW(TAG, "Error while reading SGP30 measurements.");
-		timestamp = xTaskGetTickCount();
+		id  = app_sensor_job_next(&state);
+		job = &(state.jobs[id]);
 
-		// Insert data to queues (no need to check errQUEUE_FULL)
-		xQueueOverwrite(sensor->tvoc_queue  , &tvoc_ppb  );
-		xQueueOverwrite(sensor->co2eq_queue , &co2eq_ppm );
-		if (sensor->si7021)
+		now = esp_timer_get_time();
+		if (job->release > now)
 		{
-			xQueueOverwrite(sensor->rh_queue      , &rh_percent );
-			xQueueOverwrite(sensor->celsius_queue , &celsius    );
+			esp_timer_stop(state.timer);
+			if (job->release != APP_SENSOR_JOB_IDLE)
+				esp_timer_start_once(state.timer, (uint64_t) (job->release - now));
+
+			// Block until next job step is released or a command arrives
+			xTaskNotifyWait(
+				pdFALSE          ,  // Don't clear bits on entry
+				ULONG_MAX        ,  // Clear all bits on exit
+				&ulNotifiedValue ,  // Stores the notified value
+				portMAX_DELAY    );
+
+			if (ulNotifiedValue & APP_SENSOR_TASK_EVENT_COMMAND)
+				command_pending = true;
+
+			continue;
 		}
 
-		// Check for baseline retrieval
-		secs++;
-		if (early_phase)
+		// Never let a secondary job overrun the SGP30 1 Hz slot
+		if (id != APP_SENSOR_JOB_SGP30_IAQ &&
+			now + job->budget_us > sgp30_job->release)
 		{
-			if (secs == 43200) // 12h
-			{
-				early_phase = false;
-				secs = 0;
-			}
+			ESP_LOGV(TAG, "Postponing job %d after SGP30 measurement.", id);
+			job->release = sgp30_job->release;
+			continue;
 		}
-		else if (secs == 3600) // 1h
-			secs = 0;
 
-		if (secs == 0)
+		// Never switch the heater between a Si7021 conversion start and its read
+		if (id == APP_SENSOR_JOB_HEATER && si7021_job->step)
 		{
-			ret = sgp30_get_iaq_baseline_and_read(sensor->sgp30, &baseline);
-			xQueueOverwrite(sensor->baseline_queue , &baseline);
+			ESP_LOGV(TAG, "Postponing heater after Si7021 conversion.");
+			job->release = si7021_job->release;
+			continue;
 		}
 
-		// Check for other ops instantly (max start time: period)
-		// TODO (optional)
-		xRet = xTaskNotifyWait(
-			pdFALSE          ,  // Don't clear bits on entry
-			ULONG_MAX        ,  // Clear all bits on exit
-			&ulNotifiedValue ,  // Stores the notified value
-			0                ); // Do not block
-		if (xRet == pdPASS)
+		if (id == APP_SENSOR_JOB_SGP30_IAQ && job->step == 0)
+			state.sgp30_error_us = now - job->deadline;
+
+		int64_t wait_us = app_sensor_job_run(sensor, &state, id);
+		if (wait_us != APP_SENSOR_JOB_DONE)
 		{
-			if (ulNotifiedValue & APP_SENSOR_TASK_EVENT_DELETE)
-			{
-				sensor->task = NULL; // for external check
-				vTaskDelete(NULL);
-			}
+			// Next step: keeps the deadline (job grid)
+			job->step++;
+			job->release = esp_timer_get_time() + wait_us;
+			continue;
 		}
+
+		int64_t deadline = job->deadline;
+		job->step = 0;
+		app_sensor_job_done(job, esp_timer_get_time());
+
+		if (id == APP_SENSOR_JOB_SGP30_IAQ)
+			app_sensor_timing_update(sensor, &state, state.sgp30_error_us,
+				(uint32_t) ( (job->deadline - deadline) / job->period_us - 1 ));
 	}
 }
 
@@ -156,6 +1160,8 @@ esp_err_t app_sensor_init(
 {
 	esp_err_t ret;
 
+	sensor->task = NULL;
+
 	// SGP30 handle
 	sensor->sgp30 = malloc( sizeof(sgp30_handle_t) );
 	sgp30_config_args_t sgp30_args = {
@@ -166,6 +1172,12 @@ esp_err_t app_sensor_init(
 		&sgp30_args             ,
 		sensor->sgp30       );
 
+	if (ret == ESP_ERR_NOT_FOUND)
+	{
+		ESP_LOGE(TAG, "SGP30 not found on its I2C bus.");
+		free(sensor->sgp30);
+		return ESP_ERR_NOT_FOUND;
+	}
 	if (ret != ESP_OK)
 	{
 		ESP_LOGE(TAG, "Error creating SGP30 handle.");
@@ -185,12 +1197,44 @@ esp_err_t app_sensor_init(
 		// TODO
 	*/
 
-	// Available HW baseline?
-	uint32_t baseline = APP_SENSOR_SGP30_BASELINE_VALUE;
-	if (baseline)
-		xQueueOverwrite(sensor->baseline_queue, &baseline);
+	sensor->status_queue   = xQueueCreate( 1, sizeof( app_sensor_status_t ) );
+	sensor->timing_queue   = xQueueCreate( 1, sizeof( app_sensor_timing_t ) );
+	sensor->health_queue   = xQueueCreate( 1, sizeof( app_sensor_health_t ) );
+	if (sensor->status_queue == NULL ||
+		sensor->timing_queue == NULL ||
+		sensor->health_queue == NULL )
+	{
+		ESP_LOGE(TAG, "Error creating status queues.");
+		return ESP_ERR_NO_MEM;
+	}
 
-	// Si7021 handle
+	// Stored baseline? Restored by the task after 'iaq_init'
+	uint32_t baseline;
+	int64_t  age_s;
+	sensor->startup = APP_SENSOR_STARTUP_COLD;
+	ret = app_sensor_baseline_load(&baseline, &age_s);
+	if (ret == ESP_OK)
+	{
+		// Unknown age (clock not synchronized) may exceed the one-week validity
+		if (age_s >= 0 && age_s < APP_SENSOR_SGP30_BASELINE_MAX_AGE_S)
+		{
+			ESP_LOGI(TAG, "Stored SGP30 baseline 0x%08X (%lld s old), restoring.", baseline, age_s);
+			xQueueOverwrite(sensor->baseline_queue, &baseline);
+			sensor->startup = APP_SENSOR_STARTUP_WARM;
+		}
+		else if (age_s < 0)
+			ESP_LOGW(TAG, "Stored SGP30 baseline discarded (unknown age, clock not synchronized).");
+		else
+			ESP_LOGW(TAG, "Stored SGP30 baseline discarded (too old).");
+	}
+	else if (ret == ESP_ERR_NOT_FOUND)
+	{
+		ESP_LOGI(TAG, "No stored SGP30 baseline: first start.");
+		sensor->startup = APP_SENSOR_STARTUP_FIRST;
+	}
+
+	// Si7021 handle: optional, the humidity jobs only run if it answered
+	sensor->si7021 = NULL;
 	if (APP_SENSOR_SI7021_AVAILABLE)
 	{
 		sensor->si7021 = malloc( sizeof(si7021_handle_t) );
@@ -202,24 +1246,87 @@ esp_err_t app_sensor_init(
 			&si7021_args            ,
 			sensor->si7021          );
 
-		if (ret != ESP_OK)
+		if (ret == ESP_ERR_NOT_FOUND)
+		{
+			ESP_LOGW(TAG, "Si7021 not found on its I2C bus, humidity disabled.");
+			free(sensor->si7021);
+			sensor->si7021 = NULL;
+		}
+		else if (ret != ESP_OK)
 		{
 			ESP_LOGE(TAG, "Error creating Si7021 handle.");
 			return ESP_FAIL;
 		}
+	}
+
+	// Si7021 data queues (left empty without Si7021)
+	sensor->rh_queue      = xQueueCreate( 1, sizeof(int16_t) );
+	sensor->celsius_queue = xQueueCreate( 1, sizeof(int16_t) );
+	/*
+	if (sensor->rh_queue == NULL)
+		// TODO
+	if (sensor->celsius_queue == NULL)
+		// TODO
+	*/
+
+	sensor->rh_profile = APP_SENSOR_RH_PROFILE_BALANCED;
 
-		// Si7021 data queues
-		sensor->rh_queue      = xQueueCreate( 1, sizeof(float) );
-		sensor->celsius_queue = xQueueCreate( 1, sizeof(float) );
-		/*
-		if (sensor->rh_queue == NULL)
-			// TODO
-		if (sensor->celsius_queue == NULL)
-			// TODO
-		*/
+	// Heater controller (see app_sensor_set_heater())
+	memset(&(sensor->heater), 0, sizeof(sensor->heater));
+	sensor->heater_pulses = 0;
+	sensor->rh_masked     = 0;
+
+	// Frame publishing
+	sensor->frame_queue       = xQueueCreate( 1, sizeof(app_sensor_frame_t) );
+	sensor->subscribers_mutex = xSemaphoreCreateMutex();
+	if (sensor->frame_queue == NULL || sensor->subscribers_mutex == NULL)
+	{
+		ESP_LOGE(TAG, "Error creating frame publishing resources.");
+		return ESP_ERR_NO_MEM;
 	}
-	else
-		sensor->si7021 = NULL;
+	memset(sensor->subscribers, 0, sizeof(sensor->subscribers));
+	sensor->frames_suppressed = 0;
+
+	// Command channel
+	sensor->command_queue         = xQueueCreate( 1, sizeof(app_sensor_cmd_t) );
+	sensor->command_mutex         = xSemaphoreCreateMutex();
+	sensor->command_done          = xSemaphoreCreateBinary();
+	sensor->command_result        = ESP_OK;
+	sensor->command_sequence      = 0;
+	sensor->command_done_sequence = 0;
+	if (sensor->command_queue == NULL ||
+		sensor->command_mutex == NULL ||
+		sensor->command_done  == NULL )
+	{
+		ESP_LOGE(TAG, "Error creating command channel resources.");
+		return ESP_ERR_NO_MEM;
+	}
+
+	// Sample history
+	ret = app_sensor_history_create(&(sensor->history), APP_SENSOR_HISTORY_LENGTH);
+	if (ret != ESP_OK)
+		return ret;
+
+	// Phase profiling
+	ret = app_sensor_profile_init(sensor);
+	if (ret != ESP_OK)
+	{
+		ESP_LOGE(TAG, "Error creating profiling resources.");
+		return ret;
+	}
+
+	// Humidity compensation updates
+	sensor->humidity_dead_band  = APP_SENSOR_HUMIDITY_DEAD_BAND;
+	sensor->humidity_refresh_ms = APP_SENSOR_HUMIDITY_REFRESH_MS;
+	sensor->humidity_writes     = 0;
+	sensor->humidity_skipped    = 0;
+
+	// Alert rules (see app_sensor_set_alert_rules())
+	sensor->alert_rules    = NULL;
+	sensor->alert_states   = NULL;
+	sensor->alert_count    = 0;
+	sensor->alert_callback = NULL;
+	sensor->alert_arg      = NULL;
 
 	return ESP_OK;
 }
@@ -229,13 +1336,14 @@ esp_err_t app_sensor_start(
 {
 	BaseType_t xRet;
 
-	xRet = xTaskCreate(
+	xRet = xTaskCreatePinnedToCore(
 		app_sensor_task            ,
 		"App sensor: task"         ,
 		APP_SENSOR_TASK_STACK_SIZE ,
 		sensor                     ,
 		APP_SENSOR_TASK_PRIORITY   ,
-		&(sensor->task)            );
+		&(sensor->task)            ,
+		APP_SENSOR_TASK_CORE       );
 
 	if (xRet != pdPASS)
 	{
@@ -246,6 +1354,62 @@ esp_err_t app_sensor_start(
 	return ESP_OK;
 }
 
+static esp_err_t app_sensor_command(
+		app_sensor_handle_t   *sensor ,
+		app_sensor_cmd_type_t  type   ,
+		app_sensor_job_id_t    job    ,
+		uint32_t               arg    )
+{
+	if (sensor->task == NULL)
+	{
+		ESP_LOGE(TAG, "Sensor task is not running.");
+		return ESP_ERR_INVALID_STATE;
+	}
+
+	TickType_t timeout = APP_SENSOR_COMMAND_TIMEOUT_MS / portTICK_PERIOD_MS;
+
+	// One command in flight at a time
+	xSemaphoreTake(sensor->command_mutex, portMAX_DELAY);
+
+	app_sensor_cmd_t cmd = {
+		.type     = type                       ,
+		.job      = job                        ,
+		.arg      = arg                        ,
+		.sequence = ++sensor->command_sequence };
+
+	xQueueSend(sensor->command_queue, &cmd, 0);
+	xTaskNotify(
+		sensor->task                  ,
+		APP_SENSOR_TASK_EVENT_COMMAND ,
+		eSetBits                      );
+
+	// A command that timed out earlier may still complete: skip its result
+	esp_err_t  ret   = ESP_ERR_TIMEOUT;
+	TickType_t start = xTaskGetTickCount();
+	TickType_t elapsed;
+	while ((elapsed = xTaskGetTickCount() - start) < timeout)
+	{
+		if (xSemaphoreTake(sensor->command_done, timeout - elapsed) != pdTRUE)
+			break;
+
+		if (sensor->command_done_sequence == cmd.sequence)
+		{
+			ret = sensor->command_result;
+			break;
+		}
+	}
+
+	if (ret == ESP_ERR_TIMEOUT)
+	{
+		ESP_LOGE(TAG, "Timeout waiting for command %d completion.", type);
+		xQueueReset(sensor->command_queue);
+	}
+
+	xSemaphoreGive(sensor->command_mutex);
+
+	return ret;
+}
+
 esp_err_t app_sensor_stop(
 		app_sensor_handle_t *sensor )
 {
@@ -255,23 +1419,126 @@ esp_err_t app_sensor_stop(
 		return ESP_OK;
 	}
 
-	xTaskNotify(
-		sensor->task                 ,
-		APP_SENSOR_TASK_EVENT_DELETE ,
-		eSetBits                     );
+	// Returns as soon as the current transaction ends
+	esp_err_t ret = app_sensor_command(sensor, APP_SENSOR_CMD_STOP, 0, 0);
+	if (ret != ESP_OK || sensor->task)
+	{
+		ESP_LOGE(TAG, "Could not assert task deletion.");
+		return ESP_FAIL;
+	}
+
+	return ESP_OK;
+}
+
+esp_err_t app_sensor_set_baseline(
+		app_sensor_handle_t *sensor   ,
+		uint32_t             baseline )
+{
+	return app_sensor_command(sensor, APP_SENSOR_CMD_SET_BASELINE, 0, baseline);
+}
+
+esp_err_t app_sensor_set_period(
+		app_sensor_handle_t *sensor    ,
+		uint32_t             period_ms )
+{
+	return app_sensor_set_job_period(sensor, APP_SENSOR_JOB_SGP30_IAQ, period_ms);
+}
+
+esp_err_t app_sensor_set_job_period(
+		app_sensor_handle_t *sensor    ,
+		app_sensor_job_id_t  job       ,
+		uint32_t             period_ms )
+{
+	if (job >= APP_SENSOR_JOB_COUNT)
+		return ESP_ERR_INVALID_ARG;
+
+	// Event driven jobs have no period, the heater follows its duty cycle
+	if (job == APP_SENSOR_JOB_HUMIDITY || job == APP_SENSOR_JOB_HEATER)
+		return ESP_ERR_NOT_SUPPORTED;
+
+	if (period_ms < APP_SENSOR_MIN_PERIOD_MS)
+	{
+		ESP_LOGE(TAG,
+			"Job period must be at least %d ms.",
+			APP_SENSOR_MIN_PERIOD_MS
+		);
+		return ESP_ERR_INVALID_ARG;
+	}
 
-	// Wait for deletion
-	vTaskDelay(1000 / portTICK_PERIOD_MS);
+	return app_sensor_command(sensor, APP_SENSOR_CMD_SET_PERIOD, job, period_ms);
+}
 
+esp_err_t app_sensor_set_humidity_compensation(
+		app_sensor_handle_t *sensor     ,
+		uint16_t             dead_band  ,
+		uint32_t             refresh_ms )
+{
 	if (sensor->task)
 	{
-		ESP_LOGE(TAG, "Could not assert task deletion.");
-		return ESP_FAIL;
+		ESP_LOGE(TAG, "Sensor must be stopped to change humidity compensation.");
+		return ESP_ERR_INVALID_STATE;
+	}
+
+	sensor->humidity_dead_band  = dead_band;
+	sensor->humidity_refresh_ms = refresh_ms;
+
+	return ESP_OK;
+}
+
+esp_err_t app_sensor_set_rh_profile(
+		app_sensor_handle_t     *sensor  ,
+		app_sensor_rh_profile_t  profile )
+{
+	if (profile >= APP_SENSOR_RH_PROFILE_COUNT)
+		return ESP_ERR_INVALID_ARG;
+
+	if (sensor->si7021 == NULL)
+		return ESP_ERR_NOT_SUPPORTED;
+
+	// Applied by the task on start
+	if (sensor->task == NULL)
+	{
+		sensor->rh_profile = profile;
+		return ESP_OK;
+	}
+
+	return app_sensor_command(sensor, APP_SENSOR_CMD_SET_RH_PROFILE, 0, profile);
+}
+
+esp_err_t app_sensor_set_heater(
+		app_sensor_handle_t              *sensor ,
+		const app_sensor_heater_config_t *config )
+{
+	if (sensor->task)
+	{
+		ESP_LOGE(TAG, "Sensor must be stopped to change the heater controller.");
+		return ESP_ERR_INVALID_STATE;
 	}
 
+	if (config == NULL)
+	{
+		memset(&(sensor->heater), 0, sizeof(sensor->heater));
+		return ESP_OK;
+	}
+
+	if (sensor->si7021 == NULL)
+		return ESP_ERR_NOT_SUPPORTED;
+
+	if (config->period_ms < APP_SENSOR_MIN_PERIOD_MS ||
+		config->on_ms == 0 || config->on_ms >= config->period_ms)
+		return ESP_ERR_INVALID_ARG;
+
+	sensor->heater = *config;
+
 	return ESP_OK;
 }
 
+esp_err_t app_sensor_self_test(
+		app_sensor_handle_t *sensor )
+{
+	return app_sensor_command(sensor, APP_SENSOR_CMD_SELF_TEST, 0, 0);
+}
+
 esp_err_t app_sensor_delete(
 		app_sensor_handle_t * sensor )
 {
@@ -293,20 +1560,39 @@ esp_err_t app_sensor_delete(
 	vQueueDelete(sensor->co2eq_queue);
 	vQueueDelete(sensor->tvoc_queue);
 	vQueueDelete(sensor->baseline_queue);
+	vQueueDelete(sensor->status_queue);
+	vQueueDelete(sensor->timing_queue);
+	vQueueDelete(sensor->health_queue);
 
 	// Si7021 handle
-	if (APP_SENSOR_SI7021_AVAILABLE)
+	if (sensor->si7021 != NULL)
 	{
 		ret = si7021_delete(sensor->si7021);
 		if (ret != ESP_OK)
 			ESP_LOGW(TAG, "Error deleting Si7021 handle. Possible memory leak.");
 		free(sensor->si7021);
-		
-		// Si7021 data queues
-		vQueueDelete(sensor->rh_queue);
-		vQueueDelete(sensor->celsius_queue);
+		sensor->si7021 = NULL;
 	}
 
+	// Si7021 data queues
+	vQueueDelete(sensor->rh_queue);
+	vQueueDelete(sensor->celsius_queue);
+
+	// Frame publishing
+	vQueueDelete(sensor->frame_queue);
+	vSemaphoreDelete(sensor->subscribers_mutex);
+
+	// Sample history
+	app_sensor_history_delete(&(sensor->history));
+
+	// Phase profiling
+	vSemaphoreDelete(sensor->profile_mutex);
+
+	// Command channel
+	vQueueDelete(sensor->command_queue);
+	vSemaphoreDelete(sensor->command_mutex);
+	vSemaphoreDelete(sensor->command_done);
+
 	return ESP_OK;
 }
 
@@ -340,6 +1626,66 @@ esp_err_t app_sensor_read_co2eq(
 	return ESP_OK;
 }
 
+esp_err_t app_sensor_read_health(
+		app_sensor_handle_t *sensor ,
+		app_sensor_health_t *health )
+{
+	BaseType_t xRet;
+	xRet = xQueuePeek(sensor->health_queue, health, 0);
+	if (xRet == pdFALSE)
+	{
+		ESP_LOGE(TAG, "No value found for sensor health.");
+		return ESP_FAIL;
+	}
+
+	return ESP_OK;
+}
+
+esp_err_t app_sensor_read_bus_stats(
+		app_sensor_handle_t *sensor ,
+		app_sensor_device_t  device ,
+		app_i2c_stats_t     *stats  )
+{
+	if (device == APP_SENSOR_DEVICE_SGP30)
+		app_i2c_get_stats(sensor->sgp30->i2c, stats);
+	else if (device == APP_SENSOR_DEVICE_SI7021 && sensor->si7021 != NULL)
+		app_i2c_get_stats(sensor->si7021->i2c, stats);
+	else
+		return ESP_ERR_INVALID_ARG;
+
+	return ESP_OK;
+}
+
+esp_err_t app_sensor_read_timing(
+		app_sensor_handle_t *sensor ,
+		app_sensor_timing_t *timing )
+{
+	BaseType_t xRet;
+	xRet = xQueuePeek(sensor->timing_queue, timing, 0);
+	if (xRet == pdFALSE)
+	{
+		ESP_LOGE(TAG, "No value found for sample clock timing.");
+		return ESP_FAIL;
+	}
+
+	return ESP_OK;
+}
+
+esp_err_t app_sensor_read_status(
+		app_sensor_handle_t *sensor ,
+		app_sensor_status_t *status )
+{
+	BaseType_t xRet;
+	xRet = xQueuePeek(sensor->status_queue, status, 0);
+	if (xRet == pdFALSE)
+	{
+		ESP_LOGE(TAG, "No value found for sensor status.");
+		return ESP_FAIL;
+	}
+
+	return ESP_OK;
+}
+
 esp_err_t app_sensor_read_baseline(
 		app_sensor_handle_t *sensor   ,
 		uint32_t            *baseline )
@@ -355,12 +1701,12 @@ esp_err_t app_sensor_read_baseline(
 	return ESP_OK;
 }
 
-esp_err_t app_sensor_read_rh(
-		app_sensor_handle_t *sensor     ,
-		float               *rh_percent )
+esp_err_t app_sensor_read_rh_centi(
+		app_sensor_handle_t *sensor   ,
+		int16_t             *rh_centi )
 {
 	BaseType_t xRet;
-	xRet = xQueuePeek(sensor->rh_queue, rh_percent, 0);
+	xRet = xQueuePeek(sensor->rh_queue, rh_centi, 0);
 	if (xRet == pdFALSE)
 	{
 		ESP_LOGE(TAG, "No value found for relative humidity.");
@@ -370,17 +1716,164 @@ esp_err_t app_sensor_read_rh(
 	return ESP_OK;
 }
 
+esp_err_t app_sensor_read_temperature_centi(
+		app_sensor_handle_t *sensor        ,
+		int16_t             *celsius_centi )
+{
+	BaseType_t xRet;
+	xRet = xQueuePeek(sensor->celsius_queue, celsius_centi, 0);
+	if (xRet == pdFALSE)
+	{
+		ESP_LOGE(TAG, "No value found for temperature.");
+		return ESP_FAIL;
+	}
+
+	return ESP_OK;
+}
+
+esp_err_t app_sensor_read_rh(
+		app_sensor_handle_t *sensor     ,
+		float               *rh_percent )
+{
+	int16_t rh_centi;
+	esp_err_t ret = app_sensor_read_rh_centi(sensor, &rh_centi);
+	if (ret != ESP_OK)
+		return ret;
+
+	*rh_percent = rh_centi / 100.0f;
+
+	return ESP_OK;
+}
+
 esp_err_t app_sensor_read_temperature(
 		app_sensor_handle_t *sensor  ,
 		float               *celsius )
+{
+	int16_t celsius_centi;
+	esp_err_t ret = app_sensor_read_temperature_centi(sensor, &celsius_centi);
+	if (ret != ESP_OK)
+		return ret;
+
+	*celsius = celsius_centi / 100.0f;
+
+	return ESP_OK;
+}
+
+esp_err_t app_sensor_read_frame(
+		app_sensor_handle_t *sensor ,
+		app_sensor_frame_t  *frame  )
 {
 	BaseType_t xRet;
-	xRet = xQueuePeek(sensor->celsius_queue, celsius, 0);
+	xRet = xQueuePeek(sensor->frame_queue, frame, 0);
 	if (xRet == pdFALSE)
 	{
-		ESP_LOGE(TAG, "No value found for temperature.");
+		ESP_LOGE(TAG, "No sample frame published yet.");
 		return ESP_FAIL;
 	}
 
 	return ESP_OK;
-}
\ No newline at end of file
+}
+
+static esp_err_t app_sensor_subscribe(
+		app_sensor_handle_t     *sensor ,
+		app_sensor_subscriber_t *sub    ,
+		uint8_t                 *id     )
+{
+	if (sub->decimation == 0)
+	{
+		ESP_LOGE(TAG, "Subscriber decimation factor must be at least 1.");
+		return ESP_ERR_INVALID_ARG;
+	}
+	sub->countdown = sub->decimation;
+
+	xSemaphoreTake(sensor->subscribers_mutex, portMAX_DELAY);
+
+	uint8_t i;
+	for (i = 0; i < APP_SENSOR_MAX_SUBSCRIBERS; ++i)
+		if (sensor->subscribers[i].type == APP_SENSOR_SUBSCRIBER_NONE)
+			break;
+
+	if (i == APP_SENSOR_MAX_SUBSCRIBERS)
+	{
+		xSemaphoreGive(sensor->subscribers_mutex);
+		ESP_LOGE(TAG, "No subscriber slot available.");
+		return ESP_ERR_NO_MEM;
+	}
+
+	sensor->subscribers[i] = *sub;
+	xSemaphoreGive(sensor->subscribers_mutex);
+
+	if (id)
+		*id = i;
+
+	return ESP_OK;
+}
+
+esp_err_t app_sensor_subscribe_task(
+		app_sensor_handle_t *sensor     ,
+		TaskHandle_t         task       ,
+		uint16_t             decimation ,
+		uint8_t             *id         )
+{
+	app_sensor_subscriber_t sub = {
+		.type       = APP_SENSOR_SUBSCRIBER_TASK ,
+		.decimation = decimation                 ,
+		.task       = task                       };
+
+	return app_sensor_subscribe(sensor, &sub, id);
+}
+
+esp_err_t app_sensor_subscribe_queue(
+		app_sensor_handle_t *sensor     ,
+		QueueHandle_t        queue      ,
+		uint16_t             decimation ,
+		uint8_t             *id         )
+{
+	app_sensor_subscriber_t sub = {
+		.type       = APP_SENSOR_SUBSCRIBER_QUEUE ,
+		.decimation = decimation                  ,
+		.queue      = queue                       };
+
+	return app_sensor_subscribe(sensor, &sub, id);
+}
+
+esp_err_t app_sensor_subscribe_callback(
+		app_sensor_handle_t   *sensor     ,
+		app_sensor_callback_t  callback   ,
+		void                  *arg        ,
+		uint16_t               decimation ,
+		uint8_t               *id         )
+{
+	app_sensor_subscriber_t sub = {
+		.type       = APP_SENSOR_SUBSCRIBER_CALLBACK ,
+		.decimation = decimation                     ,
+		.callback   = callback                       ,
+		.arg        = arg                            };
+
+	return app_sensor_subscribe(sensor, &sub, id);
+}
+
+esp_err_t app_sensor_unsubscribe(
+		app_sensor_handle_t *sensor ,
+		uint8_t              id     )
+{
+	if (id >= APP_SENSOR_MAX_SUBSCRIBERS)
+		return ESP_ERR_INVALID_ARG;
+
+	xSemaphoreTake(sensor->subscribers_mutex, portMAX_DELAY);
+	memset(&(sensor->subscribers[id]), 0, sizeof(app_sensor_subscriber_t));
+	xSemaphoreGive(sensor->subscribers_mutex);
+
+	return ESP_OK;
+}
+
+esp_err_t app_sensor_read_humidity_stats(
+		app_sensor_handle_t *sensor  ,
+		uint32_t            *writes  ,
+		uint32_t            *skipped )
+{
+	*writes  = sensor->humidity_writes;
+	*skipped = sensor->humidity_skipped;
+
+	return ESP_OK;
+}
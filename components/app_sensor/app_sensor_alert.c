@@ -0,0 +1,119 @@
+#include "app_sensor_priv.h"
+
+#include "esp_log.h"
+static const char *TAG = "APP_SENSOR_ALERT";
+
+#include "string.h"
+
+uint16_t app_sensor_alert_evaluate(
+		const app_sensor_alert_rule_t *rules      ,
+		app_sensor_alert_state_t      *states     ,
+		uint16_t                       count      ,
+		const int32_t                 *values     ,
+		uint32_t                       valid_mask ,
+		TickType_t                     now        ,
+		app_sensor_alert_callback_t    callback   ,
+		void                          *arg        )
+{
+	uint16_t transitions = 0;
+
+	uint16_t i;
+	for (i = 0; i < count; ++i)
+	{
+		const app_sensor_alert_rule_t *rule  = &rules[i];
+		app_sensor_alert_state_t      *state = &states[i];
+
+		if ( !(valid_mask & (1 << rule->channel)) )
+			continue;
+
+		int32_t value = values[rule->channel];
+
+		bool raise, clear;
+		if (rule->comparison == APP_SENSOR_ALERT_ABOVE)
+		{
+			raise = value > rule->threshold;
+			clear = value < rule->threshold - rule->hysteresis;
+		}
+		else
+		{
+			raise = value < rule->threshold;
+			clear = value > rule->threshold + rule->hysteresis;
+		}
+
+		if (state->active)
+		{
+			if (!clear)
+				continue;
+
+			state->active  = 0;
+			state->pending = 0;
+		}
+		else
+		{
+			if (!raise)
+			{
+				state->pending = 0;
+				continue;
+			}
+
+			// Raise condition must hold for the minimum duration.
+			if (!state->pending)
+			{
+				state->pending = 1;
+				state->since   = now;
+			}
+			if ( (now - state->since) * portTICK_PERIOD_MS < rule->min_duration_ms )
+				continue;
+
+			state->active = 1;
+		}
+
+		transitions++;
+		ESP_LOGD(TAG,
+			"Alert rule %d %s (channel %d, value %d).",
+			i, state->active ? "raised" : "cleared",
+			rule->channel, value
+		);
+
+		if (callback)
+			callback(i, rule, state->active, value, arg);
+	}
+
+	return transitions;
+}
+
+esp_err_t app_sensor_set_alert_rules(
+		app_sensor_handle_t           *sensor   ,
+		const app_sensor_alert_rule_t *rules    ,
+		app_sensor_alert_state_t      *states   ,
+		uint16_t                       count    ,
+		app_sensor_alert_callback_t    callback ,
+		void                          *arg      )
+{
+	if (sensor->task)
+	{
+		ESP_LOGE(TAG, "Sensor must be stopped to change alert rules.");
+		return ESP_ERR_INVALID_STATE;
+	}
+
+	if (count && (rules == NULL || states == NULL))
+		return ESP_ERR_INVALID_ARG;
+
+	uint16_t i;
+	for (i = 0; i < count; ++i)
+		if (rules[i].channel >= APP_SENSOR_CHANNEL_COUNT || rules[i].hysteresis < 0)
+		{
+			ESP_LOGE(TAG, "Invalid alert rule %d.", i);
+			return ESP_ERR_INVALID_ARG;
+		}
+
+	memset(states, 0, sizeof(app_sensor_alert_state_t) * count);
+
+	sensor->alert_rules    = rules;
+	sensor->alert_states   = states;
+	sensor->alert_count    = count;
+	sensor->alert_callback = callback;
+	sensor->alert_arg      = arg;
+
+	return ESP_OK;
+}
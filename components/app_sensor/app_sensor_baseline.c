@@ -0,0 +1,88 @@
+#include "app_sensor_priv.h"
+
+#include "esp_log.h"
+static const char *TAG = "APP_SENSOR_BASELINE";
+
+#include "nvs.h"
+#include "time.h"
+
+#define APP_SENSOR_BASELINE_NVS_NAMESPACE  "app_sensor"
+#define APP_SENSOR_BASELINE_NVS_KEY_VALUE  "iaq_baseline"
+#define APP_SENSOR_BASELINE_NVS_KEY_TIME   "iaq_baseline_t"
+
+// Wall clock before this (2021-01-01) is taken as not synchronized
+#define APP_SENSOR_BASELINE_VALID_EPOCH  1609459200
+
+static int64_t app_sensor_baseline_wall_time(void)
+{
+	time_t now = time(NULL);
+	return (now >= APP_SENSOR_BASELINE_VALID_EPOCH) ? (int64_t) now : 0;
+}
+
+esp_err_t app_sensor_baseline_load(
+		uint32_t *baseline ,
+		int64_t  *age_s    )
+{
+	esp_err_t ret;
+	nvs_handle_t nvs;
+
+	ret = nvs_open(APP_SENSOR_BASELINE_NVS_NAMESPACE, NVS_READONLY, &nvs);
+	if (ret == ESP_ERR_NVS_NOT_FOUND)
+		return ESP_ERR_NOT_FOUND; // Namespace not created yet
+	if (ret != ESP_OK)
+	{
+		ESP_LOGW(TAG, "Error opening NVS storage (%s).", esp_err_to_name(ret));
+		return ret;
+	}
+
+	int64_t written = 0;
+	ret = nvs_get_u32(nvs, APP_SENSOR_BASELINE_NVS_KEY_VALUE, baseline);
+	if (ret == ESP_OK)
+		ret = nvs_get_i64(nvs, APP_SENSOR_BASELINE_NVS_KEY_TIME, &written);
+	nvs_close(nvs);
+
+	if (ret == ESP_ERR_NVS_NOT_FOUND)
+		return ESP_ERR_NOT_FOUND;
+	if (ret != ESP_OK)
+	{
+		ESP_LOGW(TAG, "Error reading stored baseline (%s).", esp_err_to_name(ret));
+		return ret;
+	}
+
+	// Age only known if both timestamps come from a synchronized clock
+	int64_t now = app_sensor_baseline_wall_time();
+	if (written == 0 || now == 0 || now < written)
+		*age_s = -1;
+	else
+		*age_s = now - written;
+
+	return ESP_OK;
+}
+
+esp_err_t app_sensor_baseline_store(
+		uint32_t baseline )
+{
+	esp_err_t ret;
+	nvs_handle_t nvs;
+
+	ret = nvs_open(APP_SENSOR_BASELINE_NVS_NAMESPACE, NVS_READWRITE, &nvs);
+	if (ret != ESP_OK)
+	{
+		ESP_LOGW(TAG, "Error opening NVS storage (%s).", esp_err_to_name(ret));
+		return ret;
+	}
+
+	ret = nvs_set_u32(nvs, APP_SENSOR_BASELINE_NVS_KEY_VALUE, baseline);
+	if (ret == ESP_OK)
+		ret = nvs_set_i64(nvs, APP_SENSOR_BASELINE_NVS_KEY_TIME, app_sensor_baseline_wall_time());
+	if (ret == ESP_OK)
+		ret = nvs_commit(nvs);
+	nvs_close(nvs);
+
+	if (ret != ESP_OK)
+		ESP_LOGW(TAG, "Error storing baseline (%s).", esp_err_to_name(ret));
+	else
+		ESP_LOGI(TAG, "Stored SGP30 IAQ baseline 0x%08X.", baseline);
+
+	return ret;
+}
@@ -0,0 +1,87 @@
+#include "app_sensor_priv.h"
+
+#include "esp_log.h"
+static const char *TAG = "APP_SENSOR_BREAKER";
+
+static void app_sensor_breaker_open(
+		app_sensor_breaker_t *breaker ,
+		int64_t               now     )
+{
+	breaker->state    = APP_SENSOR_BREAKER_OPEN;
+	breaker->retry_us = now + (int64_t) breaker->backoff_ms * 1000;
+	breaker->trips++;
+}
+
+void app_sensor_breaker_init(
+		app_sensor_breaker_t *breaker )
+{
+	breaker->state          = APP_SENSOR_BREAKER_CLOSED;
+	breaker->consecutive    = 0;
+	breaker->backoff_ms     = APP_SENSOR_BREAKER_BACKOFF_MIN_MS;
+	breaker->retry_us       = 0;
+	breaker->failures       = 0;
+	breaker->trips          = 0;
+	breaker->skipped        = 0;
+}
+
+bool app_sensor_breaker_allow(
+		app_sensor_breaker_t *breaker ,
+		int64_t               now     )
+{
+	switch (breaker->state)
+	{
+		case APP_SENSOR_BREAKER_OPEN:
+			if (now < breaker->retry_us)
+			{
+				breaker->skipped++;
+				return false;
+			}
+			breaker->state = APP_SENSOR_BREAKER_HALF_OPEN; // Probe once
+			return true;
+
+		case APP_SENSOR_BREAKER_HALF_OPEN:
+		case APP_SENSOR_BREAKER_CLOSED:
+		default:
+			return true;
+	}
+}
+
+bool app_sensor_breaker_result(
+		app_sensor_breaker_t *breaker ,
+		const char           *name    ,
+		esp_err_t             ret     ,
+		int64_t               now     )
+{
+	if (ret == ESP_OK)
+	{
+		bool recovered = (breaker->state == APP_SENSOR_BREAKER_HALF_OPEN);
+		if (recovered)
+			ESP_LOGI(TAG, "%s recovered.", name);
+
+		breaker->state       = APP_SENSOR_BREAKER_CLOSED;
+		breaker->consecutive = 0;
+		breaker->backoff_ms  = APP_SENSOR_BREAKER_BACKOFF_MIN_MS;
+		return recovered;
+	}
+
+	breaker->failures++;
+	breaker->consecutive++;
+
+	if (breaker->state == APP_SENSOR_BREAKER_HALF_OPEN)
+	{
+		// Failed probe: back off exponentially
+		breaker->backoff_ms *= 2;
+		if (breaker->backoff_ms > APP_SENSOR_BREAKER_BACKOFF_MAX_MS)
+			breaker->backoff_ms = APP_SENSOR_BREAKER_BACKOFF_MAX_MS;
+		app_sensor_breaker_open(breaker, now);
+		ESP_LOGD(TAG, "%s still failing, next probe in %u ms.", name, breaker->backoff_ms);
+	}
+	else if (breaker->state == APP_SENSOR_BREAKER_CLOSED &&
+		breaker->consecutive >= APP_SENSOR_BREAKER_THRESHOLD)
+	{
+		app_sensor_breaker_open(breaker, now);
+		ESP_LOGW(TAG, "%s failing, skipped until probe in %u ms.", name, breaker->backoff_ms);
+	}
+
+	return false;
+}
@@ -0,0 +1,134 @@
+#include "app_sensor_priv.h"
+
+#include "esp_log.h"
+static const char *TAG = "APP_SENSOR_HISTORY";
+
+#include "string.h"
+#include "stdlib.h"
+
+esp_err_t app_sensor_history_create(
+		app_sensor_history_t *history ,
+		uint16_t              length  )
+{
+	// One block, one packed 16-bit array per channel
+	uint16_t *block = calloc( (size_t) length * APP_SENSOR_CHANNEL_COUNT, sizeof(uint16_t) );
+	history->mutex  = xSemaphoreCreateMutex();
+	if (block == NULL || history->mutex == NULL)
+	{
+		ESP_LOGE(TAG, "Error allocating sample history (%d samples).", length);
+		free(block);
+		if (history->mutex)
+			vSemaphoreDelete(history->mutex);
+		return ESP_ERR_NO_MEM;
+	}
+
+	uint8_t c;
+	for (c = 0; c < APP_SENSOR_CHANNEL_COUNT; ++c)
+		history->raw[c] = block + (size_t) c * length;
+
+	history->length   = length;
+	history->head     = 0;
+	history->count    = 0;
+	history->sequence = 0;
+
+	return ESP_OK;
+}
+
+esp_err_t app_sensor_history_delete(
+		app_sensor_history_t *history )
+{
+	free(history->raw[0]);
+	vSemaphoreDelete(history->mutex);
+
+	return ESP_OK;
+}
+
+void app_sensor_history_push(
+		app_sensor_history_t *history                       ,
+		const uint16_t        raw[APP_SENSOR_CHANNEL_COUNT] ,
+		uint32_t              sequence                      )
+{
+	xSemaphoreTake(history->mutex, portMAX_DELAY);
+
+	uint8_t c;
+	for (c = 0; c < APP_SENSOR_CHANNEL_COUNT; ++c)
+		history->raw[c][history->head] = raw[c];
+
+	if (++(history->head) == history->length)
+		history->head = 0;
+	if (history->count < history->length)
+		history->count++;
+	history->sequence = sequence;
+
+	xSemaphoreGive(history->mutex);
+}
+
+esp_err_t app_sensor_history_read(
+		app_sensor_handle_t  *sensor   ,
+		app_sensor_channel_t  channel  ,
+		uint16_t             *raw      ,
+		uint16_t              max      ,
+		uint16_t             *count    ,
+		uint32_t             *sequence )
+{
+	if (channel >= APP_SENSOR_CHANNEL_COUNT)
+		return ESP_ERR_INVALID_ARG;
+
+	app_sensor_history_t *history = &(sensor->history);
+
+	xSemaphoreTake(history->mutex, portMAX_DELAY);
+
+	uint16_t n = history->count < max ? history->count : max;
+
+	// Oldest requested sample, then copy in (at most) two chunks
+	uint16_t start = (history->head + history->length - n) % history->length;
+	uint16_t first = history->length - start;
+	if (first > n)
+		first = n;
+
+	const uint16_t *src = history->raw[channel];
+	memcpy(raw         , src + start , first       * sizeof(uint16_t));
+	memcpy(raw + first , src         , (n - first) * sizeof(uint16_t));
+
+	if (sequence)
+		*sequence = history->sequence;
+
+	xSemaphoreGive(history->mutex);
+
+	*count = n;
+
+	return ESP_OK;
+}
+
+esp_err_t app_sensor_history_convert(
+		app_sensor_channel_t  channel ,
+		const uint16_t       *raw     ,
+		int32_t              *values  ,
+		uint16_t              count   )
+{
+	uint16_t i;
+
+	switch (channel)
+	{
+		case APP_SENSOR_CHANNEL_TVOC:
+		case APP_SENSOR_CHANNEL_CO2EQ:
+			for (i = 0; i < count; ++i)
+				values[i] = raw[i];
+			break;
+
+		case APP_SENSOR_CHANNEL_RH:
+			for (i = 0; i < count; ++i)
+				values[i] = si7021_convert_rh_centi(raw[i]);
+			break;
+
+		case APP_SENSOR_CHANNEL_TEMPERATURE:
+			for (i = 0; i < count; ++i)
+				values[i] = si7021_convert_temperature_centi(raw[i]);
+			break;
+
+		default:
+			return ESP_ERR_INVALID_ARG;
+	}
+
+	return ESP_OK;
+}
@@ -0,0 +1,69 @@
+#include "app_sensor.h"
+
+/* Saturation water vapour density (Magnus formula over water, as in the SGP30
+ * application note) from -40 ºC to 85 ºC in 1.25 ºC steps.
+ *
+ * Values are pre-scaled by 256 * 2^32 / (100 * 65536), so that multiplying by
+ * the %RH numerator in 1/65536 % units and keeping the high 32 bits yields
+ * the absolute humidity directly in 8.8 fixed-point g/m^3. */
+#define APP_SENSOR_RHO_T_MIN   -4000 // centi-ºC
+#define APP_SENSOR_RHO_T_MAX    8500 // centi-ºC
+#define APP_SENSOR_RHO_T_STEP    125 // centi-ºC
+
+static const uint32_t rho_sat[] = {
+	    29661,     33564,     37924,     42784,     48196,     54214,
+	    60895,     68304,     76509,     85583,     95605,    106662,
+	   118844,    132250,    146986,    163164,    180905,    200339,
+	   221603,    244844,    270219,    297895,    328049,    360869,
+	   396556,    435321,    477390,    523001,    572405,    625869,
+	   683673,    746115,    813506,    886178,    964476,   1048766,
+	  1139431,   1236875,   1341520,   1453811,   1574213,   1703212,
+	  1841320,   1989070,   2147020,   2315752,   2495876,   2688027,
+	  2892867,   3111086,   3343402,   3590566,   3853354,   4132577,
+	  4429075,   4743723,   5077428,   5431130,   5805805,   6202465,
+	  6622156,   7065964,   7535011,   8030458,   8553504,   9105390,
+	  9687397,  10300847,  10947104,  11627576,  12343713,  13097011,
+	 13889011,  14721296,  15595501,  16513304,  17476430,  18486657,
+	 19545806,  20655751,  21818415,  23035773,  24309848,  25642718,
+	 27036512,  28493412,  30015652,  31605522,  33265365,  34997579,
+	 36804617,  38688988,  40653256,  42700042,  44832025,  47051940,
+	 49362578,  51766791,  54267486,  56867630,  59570248
+};
+
+#define APP_SENSOR_RHO_COUNT ( sizeof(rho_sat) / sizeof(rho_sat[0]) )
+
+uint16_t app_sensor_absolute_humidity(
+		uint16_t rh_code          ,
+		uint16_t temperature_code )
+{
+	int32_t celsius = si7021_convert_temperature_centi(temperature_code);
+	if (celsius < APP_SENSOR_RHO_T_MIN)
+		celsius = APP_SENSOR_RHO_T_MIN;
+	if (celsius > APP_SENSOR_RHO_T_MAX)
+		celsius = APP_SENSOR_RHO_T_MAX;
+
+	// Relative humidity in 1/65536 % units: 125 * code - 6 * 65536
+	int32_t rh = 125 * (int32_t) rh_code - 6 * 65536;
+	if (rh < 0)
+		rh = 0;
+	if (rh > 100 * 65536)
+		rh = 100 * 65536;
+
+	// Linear interpolation of the saturation density
+	uint32_t offset = celsius - APP_SENSOR_RHO_T_MIN;
+	uint32_t i = offset / APP_SENSOR_RHO_T_STEP;
+	uint32_t f = offset % APP_SENSOR_RHO_T_STEP;
+	if (i >= APP_SENSOR_RHO_COUNT - 1)
+	{
+		i = APP_SENSOR_RHO_COUNT - 2;
+		f = APP_SENSOR_RHO_T_STEP;
+	}
+	uint32_t rho = rho_sat[i] + ( (rho_sat[i + 1] - rho_sat[i]) * f ) / APP_SENSOR_RHO_T_STEP;
+
+	// 32x32 -> 64 multiply, keep high word (rounded)
+	uint64_t ah = ( (uint64_t) rho * (uint32_t) rh + 0x80000000u ) >> 32;
+	if (ah > 0xFFFF)
+		ah = 0xFFFF;
+
+	return (uint16_t) ah;
+}
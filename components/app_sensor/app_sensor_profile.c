@@ -0,0 +1,69 @@
+#include "app_sensor_priv.h"
+
+#include "string.h"
+
+esp_err_t app_sensor_profile_init(
+		app_sensor_handle_t *sensor )
+{
+	sensor->profile_mutex = xSemaphoreCreateMutex();
+	if (sensor->profile_mutex == NULL)
+		return ESP_ERR_NO_MEM;
+
+	app_sensor_profile_reset(sensor);
+
+	return ESP_OK;
+}
+
+void app_sensor_profile_record(
+		app_sensor_handle_t       *sensor ,
+		app_sensor_prof_phase_t    phase  ,
+		uint32_t                   cycles )
+{
+	app_sensor_profile_t *profile = &(sensor->profile[phase]);
+
+	// log2 buckets, first one for anything under 2^MIN_LOG2 cycles
+	int8_t bucket = cycles
+		? (31 - __builtin_clz(cycles)) - APP_SENSOR_PROFILE_MIN_LOG2 + 1
+		: 0;
+	if (bucket < 0)
+		bucket = 0;
+	if (bucket >= APP_SENSOR_PROFILE_BUCKETS)
+		bucket = APP_SENSOR_PROFILE_BUCKETS - 1;
+
+	xSemaphoreTake(sensor->profile_mutex, portMAX_DELAY);
+
+	if (profile->count == 0 || cycles < profile->min_cycles)
+		profile->min_cycles = cycles;
+	if (cycles > profile->max_cycles)
+		profile->max_cycles = cycles;
+	profile->total_cycles += cycles;
+	profile->count++;
+	profile->histogram[bucket]++;
+
+	xSemaphoreGive(sensor->profile_mutex);
+}
+
+esp_err_t app_sensor_profile_read(
+		app_sensor_handle_t     *sensor  ,
+		app_sensor_prof_phase_t  phase   ,
+		app_sensor_profile_t    *profile )
+{
+	if (phase >= APP_SENSOR_PROF_COUNT)
+		return ESP_ERR_INVALID_ARG;
+
+	xSemaphoreTake(sensor->profile_mutex, portMAX_DELAY);
+	*profile = sensor->profile[phase];
+	xSemaphoreGive(sensor->profile_mutex);
+
+	return ESP_OK;
+}
+
+esp_err_t app_sensor_profile_reset(
+		app_sensor_handle_t *sensor )
+{
+	xSemaphoreTake(sensor->profile_mutex, portMAX_DELAY);
+	memset(sensor->profile, 0, sizeof(sensor->profile));
+	xSemaphoreGive(sensor->profile_mutex);
+
+	return ESP_OK;
+}
@@ -6,18 +6,346 @@
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/queue.h"
+#include "freertos/semphr.h"
 #include "math.h"
 
+#define APP_SENSOR_MAX_SUBSCRIBERS 4
+
+/* Validity of a measurement cycle. Only EARLY and CALIBRATED frames are
+ * published, stored in the history and written to the queues. */
+typedef enum {
+	APP_SENSOR_VALIDITY_WARMUP     , // Fixed readings after 'iaq_init'
+	APP_SENSOR_VALIDITY_EARLY      , // No IAQ baseline yet (early phase)
+	APP_SENSOR_VALIDITY_CALIBRATED , // IAQ baseline restored or retrieved
+	APP_SENSOR_VALIDITY_STALE      , // Measurement failed: previous values
+	APP_SENSOR_VALIDITY_CRC_ERROR  , // Corrupted read from the SGP30
+} app_sensor_validity_t;
+
+/* Sample frame published by the sensor task on every valid measurement.
+ * Relative humidity and temperature are in 1/100 %RH and 1/100 ºC. */
+typedef struct {
+	uint32_t              sequence      ;
+	TickType_t            timestamp     ;
+	app_sensor_validity_t validity      ;
+	uint16_t              tvoc_ppb      ;
+	uint16_t              co2eq_ppm     ;
+	TickType_t            rh_timestamp  ; // Latest Si7021 sample
+	int16_t               rh_centi      ;
+	int16_t               celsius_centi ;
+} app_sensor_frame_t;
+
+typedef void (*app_sensor_callback_t)(
+		const app_sensor_frame_t *frame ,
+		void                     *arg   );
+
+typedef enum {
+	APP_SENSOR_SUBSCRIBER_NONE = 0 ,
+	APP_SENSOR_SUBSCRIBER_TASK     ,
+	APP_SENSOR_SUBSCRIBER_QUEUE    ,
+	APP_SENSOR_SUBSCRIBER_CALLBACK ,
+} app_sensor_subscriber_type_t;
+
+typedef struct {
+	app_sensor_subscriber_type_t  type       ;
+	uint16_t                      decimation ;
+	uint16_t                      countdown  ;
+	TaskHandle_t                  task       ;
+	QueueHandle_t                 queue      ;
+	app_sensor_callback_t         callback   ;
+	void                         *arg        ;
+} app_sensor_subscriber_t;
+
+/// ALERT ENGINE ///
+
+/* Channel values are evaluated as integers in: ppb, ppm, centi-%RH and
+ * centi-ºC respectively. */
+typedef enum {
+	APP_SENSOR_CHANNEL_TVOC        ,
+	APP_SENSOR_CHANNEL_CO2EQ       ,
+	APP_SENSOR_CHANNEL_RH          ,
+	APP_SENSOR_CHANNEL_TEMPERATURE ,
+	APP_SENSOR_CHANNEL_COUNT       ,
+} app_sensor_channel_t;
+
+typedef enum {
+	APP_SENSOR_ALERT_ABOVE , // raised when value > threshold
+	APP_SENSOR_ALERT_BELOW , // raised when value < threshold
+} app_sensor_alert_comparison_t;
+
+typedef struct {
+	app_sensor_channel_t           channel         ;
+	app_sensor_alert_comparison_t  comparison      ;
+	int32_t                        threshold       ;
+	int32_t                        hysteresis      ; // clear margin
+	uint32_t                       min_duration_ms ; // raise condition hold
+} app_sensor_alert_rule_t;
+
+typedef struct {
+	uint8_t    active  ;
+	uint8_t    pending ;
+	TickType_t since   ;
+} app_sensor_alert_state_t;
+
+typedef void (*app_sensor_alert_callback_t)(
+		uint16_t                       index  ,
+		const app_sensor_alert_rule_t *rule   ,
+		bool                           active ,
+		int32_t                        value  ,
+		void                          *arg    );
+
+/// SAMPLE HISTORY ///
+
+/* Ring buffer of the latest samples, stored as raw device codes in one packed
+ * 16-bit array per channel (SGP30 ppb/ppm, Si7021 RH/temperature codes).
+ * Conversion to physical units is done by consumers, over whole ranges. */
+typedef struct {
+	uint16_t          *raw[APP_SENSOR_CHANNEL_COUNT] ;
+	uint16_t           length                        ;
+	uint16_t           head                          ;
+	uint16_t           count                         ;
+	uint32_t           sequence                      ; // of newest sample
+	SemaphoreHandle_t  mutex                         ;
+} app_sensor_history_t;
+
+/**
+ * @brief Converts a range of raw history codes of one channel into the
+ *        channel integer units (ppb, ppm, 1/100 %RH, 1/100 ºC).
+ * 
+ * @param[in]   channel  channel of the raw codes.
+ * @param[in]   raw      raw codes, as read with app_sensor_history_read().
+ * @param[out]  values   converted values.
+ * @param[in]   count    number of codes to convert.
+ * 
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG if invalid channel.
+ */
+esp_err_t app_sensor_history_convert(
+		app_sensor_channel_t  channel ,
+		const uint16_t       *raw     ,
+		int32_t              *values  ,
+		uint16_t              count   );
+
+/// HUMIDITY COMPENSATION ///
+
+/**
+ * @brief Converts Si7021 raw relative humidity and temperature codes into
+ *        absolute humidity, in the SGP30 8.8 fixed-point g/m^3 format.
+ * 
+ *        Integer only: table interpolation of the saturation vapour density
+ *        (Magnus formula). Across -40...85 ºC and 0...100 %RH the result stays
+ *        within 0.1 % + 1 LSB (1/256 g/m^3) of the floating-point reference.
+ *        Values above 255.996 g/m^3 saturate to 0xFFFF.
+ * 
+ * @param[in]  rh_code           Si7021 raw relative humidity code.
+ * @param[in]  temperature_code  Si7021 raw temperature code.
+ * 
+ * @return absolute humidity (8.8 fixed-point g/m^3).
+ */
+uint16_t app_sensor_absolute_humidity(
+		uint16_t rh_code          ,
+		uint16_t temperature_code );
+
+/// HUMIDITY MEASUREMENT PROFILES ///
+
+#define APP_SENSOR_RH_OVERSAMPLING 4 // Samples averaged by the high-precision profile
+
+/* Si7021 resolution and oversampling, trading bus time for precision. */
+typedef enum {
+	APP_SENSOR_RH_PROFILE_LOW_LATENCY    , //  8bit RH / 12bit temperature, 1 sample
+	APP_SENSOR_RH_PROFILE_BALANCED       , // 12bit RH / 14bit temperature, 1 sample (default)
+	APP_SENSOR_RH_PROFILE_HIGH_PRECISION , // 12bit RH / 14bit temperature, averaged
+	APP_SENSOR_RH_PROFILE_COUNT          ,
+} app_sensor_rh_profile_t;
+
+/// HEATER CONTROLLER ///
+
+/* Si7021 heater duty cycle, to drive off condensation. Humidity readings are
+ * masked while heated and for 'settle_ms' after, the last unheated reading
+ * being kept (also for the SGP30 humidity compensation). */
+typedef struct {
+	uint32_t period_ms          ; // 0: heater controller disabled
+	uint32_t on_ms              ; // heater pulse, less than 'period_ms'
+	uint8_t  current            ; // heater register code, see si7021_set_heater_register()
+	int16_t  rh_threshold_centi ; // heat only above this RH (0: always)
+	uint32_t settle_ms          ; // readings masked after the pulse
+} app_sensor_heater_config_t;
+
+/// JOB SCHEDULER ///
+
+/* Jobs run by the sensor task, each with its own period and phase, as
+ * non-blocking command -> wait -> read state machines. */
+typedef enum {
+	APP_SENSOR_JOB_SGP30_IAQ , // SGP30 'measure_iaq' (1 Hz)
+	APP_SENSOR_JOB_SI7021    , // Si7021 RH/temperature measurement
+	APP_SENSOR_JOB_HUMIDITY  , // SGP30 humidity compensation (on change)
+	APP_SENSOR_JOB_BASELINE  , // SGP30 IAQ baseline retrieval (hourly)
+	APP_SENSOR_JOB_HEATER    , // Si7021 heater on/off (duty cycle)
+	APP_SENSOR_JOB_COUNT     ,
+} app_sensor_job_id_t;
+
+/// STARTUP ///
+
+/* How the SGP30 dynamic baseline compensation was started. */
+typedef enum {
+	APP_SENSOR_STARTUP_FIRST , // No stored baseline: TVOC inceptive baseline
+	APP_SENSOR_STARTUP_COLD  , // Stale/unreadable baseline: early phase
+	APP_SENSOR_STARTUP_WARM  , // Stored IAQ baseline restored
+} app_sensor_startup_t;
+
+typedef enum {
+	APP_SENSOR_PHASE_WARMUP     , // Fixed 400 ppm / 0 ppb after 'iaq_init'
+	APP_SENSOR_PHASE_CONVERGING , // TVOC still settling
+	APP_SENSOR_PHASE_READY      , // Readings trustworthy
+} app_sensor_phase_t;
+
+typedef struct {
+	app_sensor_startup_t startup  ;
+	app_sensor_phase_t   phase    ;
+	uint32_t             ready_ms ; // Time from 'iaq_init' to ready (0 if not yet)
+} app_sensor_status_t;
+
+/// SAMPLE CLOCK ///
+
+/* Release timing of the SGP30 1 Hz sampling job, driven by an esp_timer
+ * one-shot armed at each job release. Errors are actual minus intended
+ * start time. */
+typedef struct {
+	uint32_t samples       ;
+	int32_t  last_error_us ;
+	int32_t  mean_error_us ;
+	int32_t  max_error_us  ;
+	uint32_t missed        ; // Late beyond tolerance, or skipped slots
+	uint32_t stack_free    ; // Sensor task stack never used (bytes)
+} app_sensor_timing_t;
+
+/// PROFILING ///
+
+/* Sensor task phases timed with the CPU cycle counter (the task is pinned
+ * to one core, so cycle counts are consistent). */
+typedef enum {
+	APP_SENSOR_PROF_SI7021_READ      , // Si7021 measurement and read
+	APP_SENSOR_PROF_HUMIDITY_COMPUTE , // Unit and absolute humidity conversion
+	APP_SENSOR_PROF_HUMIDITY_WRITE   , // SGP30 'set_absolute_humidity'
+	APP_SENSOR_PROF_SGP30_MEASURE    , // SGP30 'measure_iaq' and read
+	APP_SENSOR_PROF_PUBLISH          , // Alerts, queues, subscribers, history
+	APP_SENSOR_PROF_BASELINE_FETCH   , // SGP30 'get_iaq_baseline' and read
+	APP_SENSOR_PROF_COUNT            ,
+} app_sensor_prof_phase_t;
+
+/* Histogram bucket 0 counts durations below 2^MIN_LOG2 cycles, bucket i the
+ * ones in [2^(MIN_LOG2+i-1), 2^(MIN_LOG2+i)), and the last one anything
+ * longer (2^24 cycles is ~105 ms at 160 MHz). */
+#define APP_SENSOR_PROFILE_BUCKETS   16
+#define APP_SENSOR_PROFILE_MIN_LOG2  10
+
+typedef struct {
+	uint32_t count                                 ;
+	uint32_t min_cycles                            ;
+	uint32_t max_cycles                            ;
+	uint64_t total_cycles                          ; // avg = total / count
+	uint32_t histogram[APP_SENSOR_PROFILE_BUCKETS] ;
+} app_sensor_profile_t;
+
+/// CIRCUIT BREAKER ///
+
+/* Per-device health: after THRESHOLD consecutive failures a device is
+ * skipped (open) until a single probe (half-open) is allowed, with the
+ * probe interval doubling on each failed probe up to BACKOFF_MAX_MS. */
+#define APP_SENSOR_BREAKER_THRESHOLD       3
+#define APP_SENSOR_BREAKER_BACKOFF_MIN_MS  1000
+#define APP_SENSOR_BREAKER_BACKOFF_MAX_MS  (64 * 1000)
+
+typedef enum {
+	APP_SENSOR_DEVICE_SGP30  ,
+	APP_SENSOR_DEVICE_SI7021 ,
+	APP_SENSOR_DEVICE_COUNT  ,
+} app_sensor_device_t;
+
+typedef enum {
+	APP_SENSOR_BREAKER_CLOSED    , // Operating normally
+	APP_SENSOR_BREAKER_OPEN      , // Failing: skipped until next probe
+	APP_SENSOR_BREAKER_HALF_OPEN , // Probing
+} app_sensor_breaker_state_t;
+
+typedef struct {
+	app_sensor_breaker_state_t state       ;
+	uint16_t                   consecutive ; // Consecutive failures
+	uint32_t                   backoff_ms  ;
+	int64_t                    retry_us    ; // Next probe (esp_timer time)
+	uint32_t                   failures    ; // Total failed operations
+	uint32_t                   trips       ; // Times opened
+	uint32_t                   skipped     ; // Operations skipped while open
+} app_sensor_breaker_t;
+
+typedef struct {
+	app_sensor_breaker_t breaker[APP_SENSOR_DEVICE_COUNT] ;
+} app_sensor_health_t;
+
+/// COMMAND CHANNEL ///
+
+typedef enum {
+	APP_SENSOR_CMD_STOP           ,
+	APP_SENSOR_CMD_SET_BASELINE   ,
+	APP_SENSOR_CMD_SET_PERIOD     ,
+	APP_SENSOR_CMD_SELF_TEST      ,
+	APP_SENSOR_CMD_SET_RH_PROFILE ,
+} app_sensor_cmd_type_t;
+
+typedef struct {
+	app_sensor_cmd_type_t type     ;
+	app_sensor_job_id_t   job      ;
+	uint32_t              arg      ;
+	uint32_t              sequence ; // Matches the completion to its caller
+} app_sensor_cmd_t;
+
 typedef struct {
 	sgp30_handle_t *sgp30          ;
 	QueueHandle_t   co2eq_queue    ;
 	QueueHandle_t   tvoc_queue     ;
 	QueueHandle_t   baseline_queue ;
 
+	app_sensor_startup_t startup      ;
+	QueueHandle_t        status_queue ;
+	QueueHandle_t        timing_queue ;
+	QueueHandle_t        health_queue ;
+
 	si7021_handle_t *si7021        ;
 	QueueHandle_t    rh_queue      ;
 	QueueHandle_t    celsius_queue ;
 
+	app_sensor_rh_profile_t rh_profile ;
+
+	app_sensor_heater_config_t heater        ;
+	volatile uint32_t          heater_pulses ;
+	volatile uint32_t          rh_masked     ;
+
+	QueueHandle_t            frame_queue                             ;
+	SemaphoreHandle_t        subscribers_mutex                       ;
+	app_sensor_subscriber_t  subscribers[APP_SENSOR_MAX_SUBSCRIBERS] ;
+	volatile uint32_t        frames_suppressed                       ;
+
+	app_sensor_history_t     history ;
+
+	const app_sensor_alert_rule_t *alert_rules    ;
+	app_sensor_alert_state_t      *alert_states   ;
+	uint16_t                       alert_count    ;
+	app_sensor_alert_callback_t    alert_callback ;
+	void                          *alert_arg      ;
+
+	uint16_t           humidity_dead_band  ;
+	uint32_t           humidity_refresh_ms ;
+	volatile uint32_t  humidity_writes     ;
+	volatile uint32_t  humidity_skipped    ;
+
+	SemaphoreHandle_t     profile_mutex                  ;
+	app_sensor_profile_t  profile[APP_SENSOR_PROF_COUNT] ;
+
+	QueueHandle_t      command_queue         ;
+	SemaphoreHandle_t  command_mutex         ;
+	SemaphoreHandle_t  command_done          ;
+	esp_err_t          command_result        ;
+	uint32_t           command_sequence      ; // Last issued
+	volatile uint32_t  command_done_sequence ; // Last completed
+
 	TaskHandle_t   task ;
 } app_sensor_handle_t;
 
@@ -30,6 +358,77 @@ esp_err_t app_sensor_start(
 esp_err_t app_sensor_stop(
 		app_sensor_handle_t *sensor );
 
+/**
+ * @brief Sets the SGP30 IAQ baseline from the running sensor task.
+ */
+esp_err_t app_sensor_set_baseline(
+		app_sensor_handle_t *sensor   ,
+		uint32_t             baseline );
+
+/**
+ * @brief Changes the SGP30 measurement period of the running sensor task. The
+ *        SGP30 dynamic baseline compensation requires a 1000 ms period.
+ */
+esp_err_t app_sensor_set_period(
+		app_sensor_handle_t *sensor    ,
+		uint32_t             period_ms );
+
+/**
+ * @brief Changes the period of a periodic job of the running sensor task. The
+ *        next run is rescheduled one new period from now.
+ */
+esp_err_t app_sensor_set_job_period(
+		app_sensor_handle_t *sensor    ,
+		app_sensor_job_id_t  job       ,
+		uint32_t             period_ms );
+
+/**
+ * @brief Configures when the SGP30 humidity compensation is rewritten. A new
+ *        absolute humidity value is only sent when it differs from the last
+ *        written one by more than 'dead_band' (8.8 fixed-point g/m^3), or
+ *        when 'refresh_ms' have passed since the last write. Must be called
+ *        while the sensor is stopped.
+ */
+esp_err_t app_sensor_set_humidity_compensation(
+		app_sensor_handle_t *sensor     ,
+		uint16_t             dead_band  ,
+		uint32_t             refresh_ms );
+
+/**
+ * @brief Selects the Si7021 measurement profile. Applied from the running
+ *        sensor task if any (the resolution is only written if it changes),
+ *        otherwise when the task starts.
+ * 
+ * @return ESP_OK on success.
+ * @return ESP_ERR_NOT_SUPPORTED if the Si7021 is not available.
+ */
+esp_err_t app_sensor_set_rh_profile(
+		app_sensor_handle_t     *sensor  ,
+		app_sensor_rh_profile_t  profile );
+
+/**
+ * @brief Configures the Si7021 heater duty cycle (see
+ *        app_sensor_heater_config_t). NULL disables the controller. Must be
+ *        called while the sensor is stopped.
+ * 
+ * @return ESP_OK on success.
+ * @return ESP_ERR_INVALID_ARG if the pulse does not fit in the period.
+ * @return ESP_ERR_NOT_SUPPORTED if the Si7021 is not available.
+ * @return ESP_ERR_INVALID_STATE if the sensor task is running.
+ */
+esp_err_t app_sensor_set_heater(
+		app_sensor_handle_t              *sensor ,
+		const app_sensor_heater_config_t *config );
+
+/**
+ * @brief Runs the SGP30 on-chip self-test from the running sensor task, then
+ *        resumes IAQ operation.
+ * 
+ * @return ESP_OK if the test succeeded, the produced error otherwise.
+ */
+esp_err_t app_sensor_self_test(
+		app_sensor_handle_t *sensor );
+
 esp_err_t app_sensor_delete(
 		app_sensor_handle_t * sensor );
 
@@ -45,10 +444,166 @@ esp_err_t app_sensor_read_baseline(
 		app_sensor_handle_t *sensor   ,
 		uint32_t            *baseline );
 
+esp_err_t app_sensor_read_rh_centi(
+		app_sensor_handle_t *sensor   ,
+		int16_t             *rh_centi );
+
+esp_err_t app_sensor_read_temperature_centi(
+		app_sensor_handle_t *sensor        ,
+		int16_t             *celsius_centi );
+
 esp_err_t app_sensor_read_rh(
 		app_sensor_handle_t *sensor     ,
 		float               *rh_percent );
 
 esp_err_t app_sensor_read_temperature(
 		app_sensor_handle_t *sensor  ,
-		float               *celsius );
\ No newline at end of file
+		float               *celsius );
+
+/**
+ * @brief Copies the raw codes of one channel for the latest (up to 'max')
+ *        samples from the history, oldest first. Raw Si7021 codes are 0 if no
+ *        measurement was available. See app_sensor_history_convert().
+ * 
+ * @param[in]   sensor    sensor handle.
+ * @param[in]   channel   channel to read.
+ * @param[out]  raw       buffer for at least 'max' raw codes.
+ * @param[in]   max       maximum number of samples to read.
+ * @param[out]  count     number of samples read.
+ * @param[out]  sequence  frame sequence of the newest sample (may be NULL).
+ * 
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG if invalid channel.
+ */
+esp_err_t app_sensor_history_read(
+		app_sensor_handle_t  *sensor   ,
+		app_sensor_channel_t  channel  ,
+		uint16_t             *raw      ,
+		uint16_t              max      ,
+		uint16_t             *count    ,
+		uint32_t             *sequence );
+
+esp_err_t app_sensor_read_frame(
+		app_sensor_handle_t *sensor ,
+		app_sensor_frame_t  *frame  );
+
+/**
+ * @brief Reads the cycle count statistics of one sensor task phase.
+ * 
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG if invalid phase.
+ */
+esp_err_t app_sensor_profile_read(
+		app_sensor_handle_t     *sensor  ,
+		app_sensor_prof_phase_t  phase   ,
+		app_sensor_profile_t    *profile );
+
+/**
+ * @brief Clears the statistics of all sensor task phases.
+ */
+esp_err_t app_sensor_profile_reset(
+		app_sensor_handle_t *sensor );
+
+/**
+ * @brief Reads the circuit breaker state and failure counters of the
+ *        sensor devices.
+ */
+esp_err_t app_sensor_read_health(
+		app_sensor_handle_t *sensor ,
+		app_sensor_health_t *health );
+
+/**
+ * @brief Reads the I2C transaction, error and retry counters of a sensor
+ *        device bus.
+ * 
+ * @return ESP_OK on success.
+ * @return ESP_ERR_INVALID_ARG if the device is unknown or not available.
+ */
+esp_err_t app_sensor_read_bus_stats(
+		app_sensor_handle_t *sensor ,
+		app_sensor_device_t  device ,
+		app_i2c_stats_t     *stats  );
+
+/**
+ * @brief Reads the SGP30 sample clock timing statistics, with the sensor task
+ *        stack high-water mark.
+ */
+esp_err_t app_sensor_read_timing(
+		app_sensor_handle_t *sensor ,
+		app_sensor_timing_t *timing );
+
+/**
+ * @brief Reads the startup status: how the SGP30 baseline compensation was
+ *        started and whether readings have converged.
+ * 
+ *        Readings are ready once the 'iaq_init' warm-up is over and TVOC has
+ *        stayed within a band around its moving average for one minute.
+ */
+esp_err_t app_sensor_read_status(
+		app_sensor_handle_t *sensor ,
+		app_sensor_status_t *status );
+
+/**
+ * @brief Subscribes a task to new sample frames.
+ * 
+ *        The task receives a notification (see ulTaskNotifyTake()) every
+ *        'decimation' published frames, right after the sensor task
+ *        publishes them. The frame can then be fetched with
+ *        app_sensor_read_frame().
+ * 
+ * @return ESP_OK on success.
+ * @return ESP_ERR_INVALID_ARG if decimation is 0.
+ * @return ESP_ERR_NO_MEM if no subscriber slot is available.
+ */
+esp_err_t app_sensor_subscribe_task(
+		app_sensor_handle_t *sensor     ,
+		TaskHandle_t         task       ,
+		uint16_t             decimation ,
+		uint8_t             *id         );
+
+/**
+ * @brief Subscribes a queue (of app_sensor_frame_t items) to new sample
+ *        frames. Frames are sent without blocking; they are dropped if the
+ *        queue is full.
+ */
+esp_err_t app_sensor_subscribe_queue(
+		app_sensor_handle_t *sensor     ,
+		QueueHandle_t        queue      ,
+		uint16_t             decimation ,
+		uint8_t             *id         );
+
+/**
+ * @brief Subscribes a callback to new sample frames. The callback runs in the
+ *        sensor task context, so it must return quickly and must not block.
+ */
+esp_err_t app_sensor_subscribe_callback(
+		app_sensor_handle_t   *sensor     ,
+		app_sensor_callback_t  callback   ,
+		void                  *arg        ,
+		uint16_t               decimation ,
+		uint8_t               *id         );
+
+esp_err_t app_sensor_unsubscribe(
+		app_sensor_handle_t *sensor ,
+		uint8_t              id     );
+
+/**
+ * @brief Installs a table of alert rules, evaluated by the sensor task right
+ *        after every SGP30 measurement. Rules and states are not copied, they
+ *        must outlive the sensor task. Must be called while the sensor is
+ *        stopped.
+ */
+esp_err_t app_sensor_set_alert_rules(
+		app_sensor_handle_t           *sensor   ,
+		const app_sensor_alert_rule_t *rules    ,
+		app_sensor_alert_state_t      *states   ,
+		uint16_t                       count    ,
+		app_sensor_alert_callback_t    callback ,
+		void                          *arg      );
+
+/**
+ * @brief Reads the number of SGP30 humidity compensation writes done and
+ *        skipped (value within the dead band) since initialization.
+ */
+esp_err_t app_sensor_read_humidity_stats(
+		app_sensor_handle_t *sensor  ,
+		uint32_t            *writes  ,
+		uint32_t            *skipped );
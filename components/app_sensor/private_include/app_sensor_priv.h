@@ -0,0 +1,123 @@
+#ifndef __APP_SENSOR_PRIV_H__
+#define __APP_SENSOR_PRIV_H__
+
+/* Internal helpers shared by the app_sensor sources, not part of the
+ * component API. */
+
+#include "app_sensor.h"
+
+/// ALERT ENGINE ///
+
+/**
+ * @brief Evaluates a table of alert rules against the given channel values.
+ * 
+ *        Each rule is raised once its condition holds continuously for
+ *        'min_duration_ms', and cleared as soon as the value crosses back the
+ *        threshold by more than 'hysteresis'. The callback is invoked on every
+ *        raise/clear transition.
+ * 
+ *        Cost is one comparison per rule. No memory is allocated: the state
+ *        table is provided by the caller, with one entry per rule.
+ * 
+ * @param[in]     rules       table of alert rules.
+ * @param[in,out] states      table of alert states (zero initialized).
+ * @param[in]     count       number of rules in both tables.
+ * @param[in]     values      current values indexed by app_sensor_channel_t.
+ * @param[in]     valid_mask  bit mask of channels with valid values.
+ * @param[in]     now         timestamp of the values.
+ * @param[in]     callback    transition callback (may be NULL).
+ * @param[in]     arg         argument passed to the callback.
+ * 
+ * @return number of transitions (raised or cleared alerts).
+ */
+uint16_t app_sensor_alert_evaluate(
+		const app_sensor_alert_rule_t *rules      ,
+		app_sensor_alert_state_t      *states     ,
+		uint16_t                       count      ,
+		const int32_t                 *values     ,
+		uint32_t                       valid_mask ,
+		TickType_t                     now        ,
+		app_sensor_alert_callback_t    callback   ,
+		void                          *arg        );
+
+/// SAMPLE HISTORY ///
+
+/**
+ * @brief Allocates a sample history for 'length' samples (8 bytes each).
+ */
+esp_err_t app_sensor_history_create(
+		app_sensor_history_t *history ,
+		uint16_t              length  );
+
+esp_err_t app_sensor_history_delete(
+		app_sensor_history_t *history );
+
+/**
+ * @brief Appends one sample (raw codes indexed by app_sensor_channel_t),
+ *        overwriting the oldest one when full.
+ */
+void app_sensor_history_push(
+		app_sensor_history_t *history                       ,
+		const uint16_t        raw[APP_SENSOR_CHANNEL_COUNT] ,
+		uint32_t              sequence                      );
+
+/// BASELINE STORAGE ///
+
+/**
+ * @brief Loads the SGP30 IAQ baseline stored in NVS (nvs_flash_init() must
+ *        have been called).
+ * 
+ * @param[out]  baseline  stored baseline value.
+ * @param[out]  age_s     seconds since the baseline was stored, or -1 if
+ *                        unknown (wall clock not synchronized on either
+ *                        store or load).
+ * 
+ * @return ESP_OK on success, ESP_ERR_NOT_FOUND if no baseline was ever
+ *         stored, or the NVS error code.
+ */
+esp_err_t app_sensor_baseline_load(
+		uint32_t *baseline ,
+		int64_t  *age_s    );
+
+/**
+ * @brief Stores the SGP30 IAQ baseline in NVS along with the wall-clock time.
+ */
+esp_err_t app_sensor_baseline_store(
+		uint32_t baseline );
+
+/// PROFILING ///
+
+esp_err_t app_sensor_profile_init(
+		app_sensor_handle_t *sensor );
+
+void app_sensor_profile_record(
+		app_sensor_handle_t       *sensor ,
+		app_sensor_prof_phase_t    phase  ,
+		uint32_t                   cycles );
+
+/// CIRCUIT BREAKER ///
+
+void app_sensor_breaker_init(
+		app_sensor_breaker_t *breaker );
+
+/**
+ * @brief Checks whether an operation on the device may be attempted now.
+ *        An open breaker becomes half-open once its backoff has elapsed.
+ */
+bool app_sensor_breaker_allow(
+		app_sensor_breaker_t *breaker ,
+		int64_t               now     );
+
+/**
+ * @brief Records the result of an allowed operation.
+ * 
+ * @return true if the device just recovered (successful half-open probe),
+ *         so that it can be re-initialized.
+ */
+bool app_sensor_breaker_result(
+		app_sensor_breaker_t *breaker ,
+		const char           *name    ,
+		esp_err_t             ret     ,
+		int64_t               now     );
+
+#endif
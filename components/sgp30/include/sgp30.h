@@ -4,6 +4,8 @@
 #include "app_i2c.h"
 #include "esp_err.h"
 
+#include <stdbool.h>
+
 
 typedef struct {
 	uint8_t   scl_gpio_pin;
@@ -14,6 +16,12 @@ typedef struct {
 	char             *name ;
 	uint8_t           address;
 	app_i2c_handle_t *i2c;
+
+	// Device identity, read once, see sgp30_get_identity()
+	bool              identity_valid;
+	uint64_t          serial;
+	uint8_t           type;
+	uint8_t           version;
 } sgp30_handle_t;
 
 /**
@@ -21,13 +29,18 @@ typedef struct {
  * 
  * Configuration options include SCL/SDA GPIO pins and handle name.
  * 
+ * The serial ID and feature set are read once into the handle identity. If
+ * the sensor does not answer, they are loaded again on next use.
+ * 
  * Memory allocation! Handle should be deleted after use. See sgp30_delete().
  * 
  * @param[in]  name  string with SGP30 name identification.
  * @param[in]  args  object with configuration parameters for SGO30 handle.
  * @param[out] sgp30 handle generated with memory allocation.
  * 
- * @return ESP_OK on success, the produced error otherwise.
+ * @return ESP_OK on success.
+ * @return ESP_ERR_NOT_FOUND if no SGP30 answers on the bus.
+ * @return The produced error otherwise.
  */
 esp_err_t sgp30_create(
 		char *name                 ,
@@ -44,6 +57,18 @@ esp_err_t sgp30_create(
 esp_err_t sgp30_delete(
 		sgp30_handle_t *sgp30 );
 
+/**
+ * @brief Checks that the SGP30 answers on its address (address-only
+ *        transaction, no command is sent).
+ * 
+ * @param[in]  sgp30  handle for the SGP30 sensor.
+ * 
+ * @return ESP_OK if the device is present.
+ * @return APP_I2C_ERR_NACK_ADDR if it did not answer, the bus error otherwise.
+ */
+esp_err_t sgp30_probe(
+		sgp30_handle_t *sgp30 );
+
 
 /**
  * @brief Sends a command 'iaq_init', which initializes the air quality
@@ -96,6 +121,29 @@ esp_err_t sgp30_measure_iaq_and_read(
 		uint16_t       *tvoc          ,
 		uint16_t       *co2_eq        );
 
+/**
+ * @brief Non-blocking split of sgp30_measure_iaq_and_read(): sends the
+ *        'measure_iaq' command and returns the time to wait before reading
+ *        the results with sgp30_measure_iaq_read().
+ * 
+ * @param[in]   sgp30    handle for the SGP30 sensor.
+ * @param[out]  wait_ms  time to wait before reading.
+ * 
+ * @return ESP_OK on success, the produced error otherwise.
+ */
+esp_err_t sgp30_measure_iaq_start(
+		sgp30_handle_t *sgp30         ,
+		uint16_t       *wait_ms       );
+
+/**
+ * @brief Reads the results of a 'measure_iaq' command previously sent with
+ *        sgp30_measure_iaq_start().
+ */
+esp_err_t sgp30_measure_iaq_read(
+		sgp30_handle_t *sgp30         ,
+		uint16_t       *tvoc          ,
+		uint16_t       *co2_eq        );
+
 /**
  * @brief Sends a command 'get_iaq_baseline' and reads the IAQ baseline value
  *        sent by the SGP30.
@@ -177,7 +225,7 @@ esp_err_t sgp30_measure_test(
  *        (SGP30) and version number.
  * 
  * @param[in]   sgp30    handle for the SGP30 sensor.
- * @param[out]  type     value determining the device type.
+ * @param[out]  type     value determining the device type (0 for SGP30).
  * @param[out]  version  number of the device version.
  * 
  * @return ESP_OK on success, the produced error otherwise.
@@ -236,4 +284,36 @@ esp_err_t sgp30_set_tvoc_baseline(
 		sgp30_handle_t *sgp30         ,
 		uint16_t        baseline      );
 
+/**
+ * @brief Sends a 'get_serial_id' command and reads the 48bit SGP30 serial ID.
+ * 
+ * @param[in]   sgp30   handle for the SGP30 sensor.
+ * @param[out]  serial  serial ID of the SGP30 sensor.
+ * 
+ * @return ESP_OK on success, the produced error otherwise.
+ */
+esp_err_t sgp30_get_serial_id_and_read(
+		sgp30_handle_t *sgp30         ,
+		uint64_t       *serial        );
+
+/**
+ * @brief Retrieves the SGP30 serial ID and feature set from the handle
+ *        identity.
+ * 
+ *        The bus is only accessed ('get_serial_id' and 'get_feature_set') if
+ *        the identity could not be read when the handle was created.
+ * 
+ * @param[in]   sgp30    handle for the SGP30 sensor.
+ * @param[out]  serial   serial ID (may be NULL).
+ * @param[out]  type     product type (may be NULL).
+ * @param[out]  version  product version (may be NULL).
+ * 
+ * @return ESP_OK on success, the produced error otherwise.
+ */
+esp_err_t sgp30_get_identity(
+		sgp30_handle_t *sgp30         ,
+		uint64_t       *serial        ,
+		uint8_t        *type          ,
+		uint8_t        *version       );
+
 #endif
\ No newline at end of file
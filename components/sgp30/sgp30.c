@@ -12,6 +12,12 @@ static const char *TAG = "SGP30";
 #define SGP30_I2C_SCL_PERIOD_MS  2
 #define SGP30_I2C_OP_DELAY_MS    (SGP30_I2C_SCL_PERIOD_MS / 2)
 
+static esp_err_t sgp30_timing_calibrate(
+		sgp30_handle_t *sgp30 );
+
+static esp_err_t sgp30_identity_load(
+		sgp30_handle_t *sgp30 );
+
 esp_err_t sgp30_create(
 		char *name                 ,
 		sgp30_config_args_t *args  ,
@@ -38,10 +44,11 @@ esp_err_t sgp30_create(
 
 	ESP_LOGV(TAG, "Loading SGP30 I2C configuration.");
 	app_i2c_config_args_t i2c_args = {
-		.scl = args->scl_gpio_pin                 ,
-		.sda = args->sda_gpio_pin                 ,
-		.scl_period_ms = SGP30_I2C_SCL_PERIOD_MS  ,
-		.op_delay_ms   = SGP30_I2C_OP_DELAY_MS    };
+		.scl            = args->scl_gpio_pin      ,
+		.sda            = args->sda_gpio_pin      ,
+		.scl_period_ms  = SGP30_I2C_SCL_PERIOD_MS ,
+		.op_delay_ms    = SGP30_I2C_OP_DELAY_MS   ,
+		.half_period_us = 0                       };
 
 	esp_err_t ret;
 	app_i2c_handle_t *i2c = malloc(sizeof(app_i2c_handle_t));
@@ -55,6 +62,36 @@ esp_err_t sgp30_create(
 
 	sgp30->i2c = i2c;
 
+	// Absent device: fail fast, before the identity reads and their retries
+	ret = sgp30_probe(sgp30);
+	if (ret != ESP_OK)
+	{
+		ESP_LOGW(TAG,
+			"No SGP30 answering at address 0x%02X (0x%X).",
+			sgp30->address, ret
+		);
+
+		free(sgp30->name);
+		app_i2c_delete(i2c);
+		free(i2c);
+
+		return ret == APP_I2C_ERR_NACK_ADDR ? ESP_ERR_NOT_FOUND : ret;
+	}
+
+	// Bus timing: calibrated once per deployment, then restored from NVS
+	if (app_i2c_timing_load(i2c) == ESP_ERR_NOT_FOUND &&
+		sgp30_timing_calibrate(sgp30) != ESP_OK )
+		ESP_LOGW(TAG, "Could not calibrate SGP30 I2C timing, using default.");
+
+	sgp30->identity_valid = false;
+	sgp30->serial         = 0;
+	sgp30->type           = 0;
+	sgp30->version        = 0;
+
+	// Not fatal: retried on next use
+	if (sgp30_identity_load(sgp30) != ESP_OK)
+		ESP_LOGW(TAG, "Could not load SGP30 identity, deferring.");
+
 	return ESP_OK;
 }
 
@@ -76,170 +113,69 @@ esp_err_t sgp30_delete(
 	return ESP_OK;
 }
 
-// *** *** //
-
-
-
-
-
-// ** SGP30 I2C BASIC METHODS ** //
-
-#define SGP30_I2C_CRC8_POLY  0x31 // x^8 + x^5 + x^4 + 1
-#define SGP30_I2C_CRC8_INIT  0xFF
-#define SGP30_I2C_CRC8_XOR   0x00
-
-static uint8_t crc8_checksum_calculate(
-		uint8_t  *bytes ,
-		uint16_t  count )
+esp_err_t sgp30_probe(
+		sgp30_handle_t *sgp30 )
 {
-	ESP_LOGD(TAG, "Calculating CRC8 checksum for %d bytes.", count);
+	ESP_LOGD(TAG, "Probing SGP30 at address 0x%02X.", sgp30->address);
 
-	uint8_t crc8 = SGP30_I2C_CRC8_INIT;
-	uint16_t i, j;
-	for (i = 0; i < count; ++i)
-	{
-		crc8 ^= bytes[i];
-		for (j = 0; j < 8; ++j)
-		{
-			if (crc8 & 0x80)
-				crc8 = (crc8 << 1) ^ SGP30_I2C_CRC8_POLY;
-			else
-				crc8 = (crc8 << 1);
-		}
-		crc8 ^= SGP30_I2C_CRC8_XOR;
-	}
-
-	return crc8;
+	return app_i2c_probe(sgp30->i2c, sgp30->address);
 }
 
-static void sgp30_sleep_ms(
-		uint16_t ms )
-{
-	app_i2c_ll_sleep(ms);
-}
-
-static esp_err_t sgp30_i2c_checksum_check(
-		uint8_t  *bytes    ,
-		uint16_t  count    ,
-		uint8_t   checksum )
-{
-	ESP_LOGD(TAG, "Checking checksum correctness.");
+// *** *** //
 
-	uint8_t crc8 = crc8_checksum_calculate(bytes, count);
-	if (crc8 != checksum)
-	{
-		ESP_LOGE(TAG, "Data checksum does not match with correspondant CRC8.");
-		return ESP_FAIL;
-	}
 
-	return ESP_OK;
-}
 
-static esp_err_t sgp30_i2c_send_command(
-	app_i2c_handle_t *i2c     ,
-	uint8_t           address ,
-	uint16_t          command )
-{
-	ESP_LOGD(TAG, "Sending command to device.");
 
-	uint16_t count = 2;
-	uint8_t  buf[count];
 
-	buf[0] = (uint8_t) (command >> 8 );
-	buf[1] = (uint8_t) (command & 0x00FF);
+// ** SGP30 COMMAND DESCRIPTORS ** //
 
-	esp_err_t ret;
-	ret = app_i2c_write(i2c, address, buf, count);
-	if (ret != ESP_OK)
-	{
-		ESP_LOGE(TAG,
-			"Error while sending command %X to device address %X.",
-			command,
-			address
-		);
-		return ret;
-	}
+#define SGP30_I2C_CRC8_INIT  0xFF
 
-	return ESP_OK;
-}
+#define SGP30_I2C_RETURN_MEASURE_TEST 0xD400
 
-static esp_err_t sgp30_i2c_send_command_with_data(
-	app_i2c_handle_t *i2c      ,
-	uint8_t           address  ,
-	uint16_t          command  ,
-	uint16_t         *data     ,
-	uint16_t          num_data )
+typedef enum {
+	SGP30_CMD_IAQ_INIT                    ,
+	SGP30_CMD_MEASURE_IAQ                 ,
+	SGP30_CMD_GET_IAQ_BASELINE            ,
+	SGP30_CMD_SET_IAQ_BASELINE            ,
+	SGP30_CMD_SET_ABSOLUTE_HUMIDITY       ,
+	SGP30_CMD_MEASURE_TEST                ,
+	SGP30_CMD_GET_FEATURE_SET             ,
+	SGP30_CMD_MEASURE_RAW                 ,
+	SGP30_CMD_GET_TVOC_INCEPTIVE_BASELINE ,
+	SGP30_CMD_SET_TVOC_BASELINE           ,
+	SGP30_CMD_GET_SERIAL_ID               ,
+} sgp30_cmd_id_t;
+
+// 16-bit opcodes, 16-bit words with CRC in both directions
+static const app_i2c_cmd_t sgp30_cmds[] = {
+	//                                         name                           opcode  op w  arg wait resp  crc               retry budget
+	[SGP30_CMD_IAQ_INIT]                    = { "iaq_init"                    , 0x2003, 2, 2, 0,  10, 0, APP_I2C_CRC_BOTH, 2, 100 },
+	[SGP30_CMD_MEASURE_IAQ]                 = { "measure_iaq"                 , 0x2008, 2, 2, 0,  24, 2, APP_I2C_CRC_BOTH, 1,  50 },
+	[SGP30_CMD_GET_IAQ_BASELINE]            = { "get_iaq_baseline"            , 0x2015, 2, 2, 0,  10, 2, APP_I2C_CRC_BOTH, 2, 100 },
+	[SGP30_CMD_SET_IAQ_BASELINE]            = { "set_iaq_baseline"            , 0x201E, 2, 2, 2,  10, 0, APP_I2C_CRC_BOTH, 2, 100 },
+	[SGP30_CMD_SET_ABSOLUTE_HUMIDITY]       = { "set_absolute_humidity"       , 0x2061, 2, 2, 1,  10, 0, APP_I2C_CRC_BOTH, 2, 100 },
+	[SGP30_CMD_MEASURE_TEST]                = { "measure_test"                , 0x2032, 2, 2, 0, 220, 1, APP_I2C_CRC_BOTH, 0,   0 },
+	[SGP30_CMD_GET_FEATURE_SET]             = { "get_feature_set"             , 0x202F, 2, 2, 0,  10, 1, APP_I2C_CRC_BOTH, 2, 100 },
+	[SGP30_CMD_MEASURE_RAW]                 = { "measure_raw"                 , 0x2050, 2, 2, 0,  25, 2, APP_I2C_CRC_BOTH, 1,  50 },
+	[SGP30_CMD_GET_TVOC_INCEPTIVE_BASELINE] = { "get_tvoc_inceptive_baseline" , 0x20B3, 2, 2, 0,  10, 1, APP_I2C_CRC_BOTH, 2, 100 },
+	[SGP30_CMD_SET_TVOC_BASELINE]           = { "set_tvoc_baseline"           , 0x2077, 2, 2, 1,  10, 0, APP_I2C_CRC_BOTH, 2, 100 },
+	[SGP30_CMD_GET_SERIAL_ID]               = { "get_serial_id"               , 0x3682, 2, 2, 0,   1, 3, APP_I2C_CRC_BOTH, 2, 100 },
+};
+
+static esp_err_t sgp30_execute(
+		sgp30_handle_t *sgp30    ,
+		sgp30_cmd_id_t  id       ,
+		const uint16_t *args     ,
+		uint16_t       *response )
 {
-	ESP_LOGD(TAG, "Sending command with args to device.");
-
-	uint16_t count = 2 + num_data * 3; // addr + data + crc
-	uint8_t  buf[count];
-	uint16_t i = 0;
-
-	buf[i++] = (uint8_t) (command >> 8 );
-	buf[i++] = (uint8_t) (command & 0x00FF);
-
-	uint16_t j;
-	for (j = 0; j < num_data; ++j)
-	{
-		uint8_t *buf_ptr = &buf[i];
-		buf[i++] = (uint8_t) (data[j] >> 8);
-		buf[i++] = (uint8_t) (data[j] & 0x00FF);
-		buf[i++] = crc8_checksum_calculate(buf_ptr, 2);
-	}
-
-	esp_err_t ret;
-	ret = app_i2c_write(i2c, address, buf, count);
-	if (ret != ESP_OK)
-	{
-		ESP_LOGE(TAG,
-			"Error while sending command 0x%X with args to device address 0x%X.",
-			command,
-			address
-		);
-		return ret;
-	}
-
-	return ESP_OK;
-}
-
-static esp_err_t sgp30_i2c_read(
-	app_i2c_handle_t *i2c     ,
-	uint8_t           address ,
-	uint16_t         *data    ,
-	uint16_t          num_data)
-{
-	ESP_LOGD(TAG, "Reading from device.");
-
-	uint16_t count = num_data * 3;
-	uint8_t buf[count];
-
-	esp_err_t ret;
-	ret = app_i2c_read(i2c, address, buf, count);
-	if (ret != ESP_OK)
-	{
-		ESP_LOGE(TAG,
-			"Error while reading from device address %X.",
-			address
-		);
-		return ret;
-	}
-
-	uint16_t j;
-	for (j = 0; j < num_data; ++j)
-	{
-		uint8_t *data_buf = buf + 3*j;
-		ret = sgp30_i2c_checksum_check(data_buf, 2, data_buf[2]);
-		if (ret != ESP_OK)
-		{
-			ESP_LOGE(TAG, "Error in checksum of read data.");
-			return ret;
-		}
-
-		data[j] = ( (uint16_t) data_buf[0] << 8) | ( (uint16_t) data_buf[1] );
-	}
-
-	return ESP_OK;
+	return app_i2c_cmd_execute(
+		sgp30->i2c          ,
+		sgp30->address      ,
+		SGP30_I2C_CRC8_INIT ,
+		&sgp30_cmds[id]     ,
+		args                ,
+		response            );
 }
 
 // *** *** //
@@ -250,91 +186,10 @@ static esp_err_t sgp30_i2c_read(
 
 // ** SGP30 COMMAND METHODS ** //
 
-#define SGP30_I2C_CMD_IAQ_INIT                     0x2003
-#define SGP30_I2C_CMD_MEASURE_IAQ                  0x2008
-#define SGP30_I2C_CMD_GET_IAQ_BASELINE             0x2015
-#define SGP30_I2C_CMD_SET_IAQ_BASELINE             0x201E
-#define SGP30_I2C_CMD_SET_ABSOLUTE_HUMIDITY        0x2061
-#define SGP30_I2C_CMD_MEASURE_TEST                 0x2032
-#define SGP30_I2C_CMD_GET_FEATURE_SET              0x202F
-#define SGP30_I2C_CMD_MEASURE_RAW                  0x2050
-#define SGP30_I2C_CMD_GET_TVOC_INCEPTIVE_BASELINE  0x20B3
-#define SGP30_I2C_CMD_SET_TVOC_BASELINE            0x2077
-
-#define SGP30_I2C_WAIT_MS_IAQ_INIT                     10
-#define SGP30_I2C_WAIT_MS_MEASURE_IAQ                  24
-#define SGP30_I2C_WAIT_MS_GET_IAQ_BASELINE             10
-#define SGP30_I2C_WAIT_MS_SET_IAQ_BASELINE             10
-#define SGP30_I2C_WAIT_MS_SET_ABSOLUTE_HUMIDITY        10
-#define SGP30_I2C_WAIT_MS_MEASURE_TEST                 220
-#define SGP30_I2C_WAIT_MS_GET_FEATURE_SET              10
-#define SGP30_I2C_WAIT_MS_MEASURE_RAW                  25
-#define SGP30_I2C_WAIT_MS_GET_TVOC_INCEPTIVE_BASELINE  10
-#define SGP30_I2C_WAIT_MS_SET_TVOC_BASELINE            10
-
-#define SGP30_I2C_RETURN_MEASURE_TEST 0xD400
-
 esp_err_t sgp30_iaq_init(
 		sgp30_handle_t *sgp30 )
 {
-	esp_err_t ret;
-	ret = sgp30_i2c_send_command(
-		sgp30->i2c                     ,
-		sgp30->address                 ,
-		SGP30_I2C_CMD_IAQ_INIT );
-
-	if (ret != ESP_OK)
-	{
-		ESP_LOGE(TAG, "Error with command 'iaq_init'.");
-		return ret;
-	}
-
-	sgp30_sleep_ms(SGP30_I2C_WAIT_MS_IAQ_INIT);
-
-	return ESP_OK;
-}
-
-static esp_err_t sgp30_measure_iaq(
-		sgp30_handle_t *sgp30 )
-{
-	esp_err_t ret;
-	ret = sgp30_i2c_send_command(
-		sgp30->i2c                ,
-		sgp30->address            ,
-		SGP30_I2C_CMD_MEASURE_IAQ );
-
-	if (ret != ESP_OK)
-	{
-		ESP_LOGE(TAG, "Error with command 'measure_iaq'.");
-		return ret;
-	}
-
-	return ESP_OK;
-}
-
-static esp_err_t sgp30_read_measure_iaq(
-	sgp30_handle_t *sgp30         ,
-	uint16_t       *tvoc          ,
-	uint16_t       *co2_eq        )
-{
-	esp_err_t ret;
-	uint16_t data[2];
-
-	ret = sgp30_i2c_read(
-		sgp30->i2c     ,
-		sgp30->address ,
-		data           ,
-		2              );
-	if (ret != ESP_OK)
-	{
-		ESP_LOGE(TAG, "Error reading after command 'measure_iaq'.");
-		return ret;
-	}
-
-	*tvoc   = data[0];
-	*co2_eq = data[1];
-
-	return ESP_OK;
+	return sgp30_execute(sgp30, SGP30_CMD_IAQ_INIT, NULL, NULL);
 }
 
 esp_err_t sgp30_measure_iaq_and_read(
@@ -343,56 +198,48 @@ esp_err_t sgp30_measure_iaq_and_read(
 		uint16_t       *co2_eq        )
 {
 	esp_err_t ret;
-	ret = sgp30_measure_iaq(sgp30);
-	if (ret != ESP_OK)
-		return ret;
-
-	sgp30_sleep_ms(SGP30_I2C_WAIT_MS_MEASURE_IAQ);
+	uint16_t data[2];
 
-	ret = sgp30_read_measure_iaq(sgp30, tvoc, co2_eq);
+	ret = sgp30_execute(sgp30, SGP30_CMD_MEASURE_IAQ, NULL, data);
 	if (ret != ESP_OK)
 		return ret;
 
+	*co2_eq = data[0];
+	*tvoc   = data[1];
+
 	return ESP_OK;
 }
 
-static esp_err_t sgp30_get_iaq_baseline(
-		sgp30_handle_t *sgp30 )
+esp_err_t sgp30_measure_iaq_start(
+		sgp30_handle_t *sgp30         ,
+		uint16_t       *wait_ms       )
 {
-	esp_err_t ret;
-	ret = sgp30_i2c_send_command(
-		sgp30->i2c                     ,
-		sgp30->address                 ,
-		SGP30_I2C_CMD_GET_IAQ_BASELINE );
+	const app_i2c_cmd_t *cmd = &sgp30_cmds[SGP30_CMD_MEASURE_IAQ];
 
-	if (ret != ESP_OK)
-	{
-		ESP_LOGE(TAG, "Error with command 'get_iaq_baseline'.");
-		return ret;
-	}
+	*wait_ms = cmd->wait_ms;
 
-	return ESP_OK;
+	return app_i2c_cmd_send(sgp30->i2c, sgp30->address, SGP30_I2C_CRC8_INIT, cmd, NULL);
 }
 
-static esp_err_t sgp30_read_get_iaq_baseline(
+esp_err_t sgp30_measure_iaq_read(
 		sgp30_handle_t *sgp30         ,
-		uint32_t       *baseline      )
+		uint16_t       *tvoc          ,
+		uint16_t       *co2_eq        )
 {
 	esp_err_t ret;
-
 	uint16_t data[2];
-	ret = sgp30_i2c_read(
-		sgp30->i2c     ,
-		sgp30->address ,
-		data           ,
-		2              );
+
+	ret = app_i2c_cmd_read(
+		sgp30->i2c                              ,
+		sgp30->address                          ,
+		SGP30_I2C_CRC8_INIT                     ,
+		&sgp30_cmds[SGP30_CMD_MEASURE_IAQ]      ,
+		data                                    );
 	if (ret != ESP_OK)
-	{
-		ESP_LOGE(TAG, "Error reading after command 'get_iaq_baseline'.");
 		return ret;
-	}
 
-	*baseline = ( (uint32_t) data[0] << 16 ) | ( (uint32_t) data[1] );
+	*co2_eq = data[0];
+	*tvoc   = data[1];
 
 	return ESP_OK;
 }
@@ -402,16 +249,14 @@ esp_err_t sgp30_get_iaq_baseline_and_read(
 		uint32_t       *baseline      )
 {
 	esp_err_t ret;
-	ret = sgp30_get_iaq_baseline(sgp30);
-	if (ret != ESP_OK)
-		return ret;
-
-	sgp30_sleep_ms(SGP30_I2C_WAIT_MS_GET_IAQ_BASELINE);
+	uint16_t data[2];
 
-	ret = sgp30_read_get_iaq_baseline(sgp30, baseline);
+	ret = sgp30_execute(sgp30, SGP30_CMD_GET_IAQ_BASELINE, NULL, data);
 	if (ret != ESP_OK)
 		return ret;
 
+	*baseline = ( (uint32_t) data[0] << 16 ) | ( (uint32_t) data[1] );
+
 	return ESP_OK;
 }
 
@@ -419,76 +264,30 @@ esp_err_t sgp30_set_iaq_baseline(
 		sgp30_handle_t *sgp30         ,
 		uint32_t        baseline      )
 {
-	esp_err_t ret;
+	// Reversed from 'get_iaq_baseline' (CO2eq << 16 | TVOC): TVOC word first
+	uint16_t data[2] = {
+		(uint16_t) (baseline & 0xFFFF)  ,
+		(uint16_t) (baseline >> 16)     };
 
-	ret = sgp30_i2c_send_command_with_data(
-		sgp30->i2c                     ,
-		sgp30->address                 ,
-		SGP30_I2C_CMD_SET_IAQ_BASELINE ,
-		(uint16_t *)&baseline          ,
-		2                              );
-	if (ret != ESP_OK)
-	{
-		ESP_LOGE(TAG, "Error with command 'set_iaq_baseline'.");
-		return ret;
-	}
-
-	sgp30_sleep_ms(SGP30_I2C_WAIT_MS_SET_IAQ_BASELINE);
-
-	return ESP_OK;
+	return sgp30_execute(sgp30, SGP30_CMD_SET_IAQ_BASELINE, data, NULL);
 }
 
 esp_err_t sgp30_set_absolute_humidity(
 		sgp30_handle_t *sgp30         ,
 		uint16_t        humidity      )
 {
-	esp_err_t ret;
-
-	ret = sgp30_i2c_send_command_with_data(
-		sgp30->i2c                          ,
-		sgp30->address                      ,
-		SGP30_I2C_CMD_SET_ABSOLUTE_HUMIDITY ,
-		&humidity                           ,
-		1                                   );
-	if (ret != ESP_OK)
-	{
-		ESP_LOGE(TAG, "Error with command 'set_absolute_humidity'.");
-		return ret;
-	}
-
-	sgp30_sleep_ms(SGP30_I2C_WAIT_MS_SET_ABSOLUTE_HUMIDITY);
-
-	return ESP_OK;
+	return sgp30_execute(sgp30, SGP30_CMD_SET_ABSOLUTE_HUMIDITY, &humidity, NULL);
 }
 
 esp_err_t sgp30_measure_test(
 		sgp30_handle_t *sgp30 )
 {
 	esp_err_t ret;
-
-	ret = sgp30_i2c_send_command(
-		sgp30->i2c                 ,
-		sgp30->address             ,
-		SGP30_I2C_CMD_MEASURE_TEST );
-	if (ret != ESP_OK)
-	{
-		ESP_LOGE(TAG, "Error with command 'measure_test'.");
-		return ret;
-	}
-
-	sgp30_sleep_ms(SGP30_I2C_WAIT_MS_MEASURE_TEST);
-
 	uint16_t data;
-	ret = sgp30_i2c_read(
-		sgp30->i2c     ,
-		sgp30->address ,
-		&data          ,
-		1              );
+
+	ret = sgp30_execute(sgp30, SGP30_CMD_MEASURE_TEST, NULL, &data);
 	if (ret != ESP_OK)
-	{
-		ESP_LOGE(TAG, "Error reading after command 'measure_test.");
 		return ret;
-	}
 
 	if (data != SGP30_I2C_RETURN_MEASURE_TEST)
 	{
@@ -499,103 +298,35 @@ esp_err_t sgp30_measure_test(
 	return ESP_OK;
 }
 
-static esp_err_t sgp30_get_feature_set(
-		sgp30_handle_t *sgp30   )
-{
-	esp_err_t ret;
-
-	ret = sgp30_i2c_send_command(
-		sgp30->i2c                    ,
-		sgp30->address                ,
-		SGP30_I2C_CMD_GET_FEATURE_SET );
-	if (ret != ESP_OK)
-	{
-		ESP_LOGE(TAG, "Error with command 'get_feature_set'.");
-		return ret;
-	}
-
-	return ESP_OK;
-}
-
-static esp_err_t sgp30_read_get_feature_set(
-		sgp30_handle_t *sgp30   ,
-		uint8_t       *type    ,
-		uint8_t       *version )
-{
-	esp_err_t ret;
-	uint16_t data;
-
-	ret = sgp30_i2c_read(
-		sgp30->i2c     ,
-		sgp30->address ,
-		&data          ,
-		1              );
-
-	if (ret != ESP_OK)
-	{
-		ESP_LOGE(TAG, "Error reading after command 'get_feature_set'.");
-		return ret;
-	}
-
-	return ESP_OK;
-}
-
 esp_err_t sgp30_get_feature_set_and_read(
 		sgp30_handle_t *sgp30         ,
 		uint8_t        *type          ,
 		uint8_t        *version       )
 {
 	esp_err_t ret;
-	ret = sgp30_get_feature_set(sgp30);
-	if (ret != ESP_OK)
-		return ret;
-
-	sgp30_sleep_ms(SGP30_I2C_WAIT_MS_GET_FEATURE_SET);
+	uint16_t data;
 
-	ret = sgp30_read_get_feature_set(sgp30, type, version);
+	ret = sgp30_execute(sgp30, SGP30_CMD_GET_FEATURE_SET, NULL, &data);
 	if (ret != ESP_OK)
 		return ret;
 
-	return ESP_OK;
-}
-
-static esp_err_t sgp30_measure_raw(
-		sgp30_handle_t *sgp30 )
-{
-	esp_err_t ret;
-
-	ret = sgp30_i2c_send_command(
-		sgp30->i2c                    ,
-		sgp30->address                ,
-		SGP30_I2C_CMD_MEASURE_RAW );
-	if (ret != ESP_OK)
-	{
-		ESP_LOGE(TAG, "Error with command 'measure_raw'.");
-		return ret;
-	}
+	*type    = (uint8_t) (data >> 12);
+	*version = (uint8_t) (data & 0x00FF);
 
 	return ESP_OK;
 }
 
-static esp_err_t sgp30_read_measure_raw(
-		sgp30_handle_t *sgp30    ,
-		uint16_t       *h2       ,
-		uint16_t       *ethanol  )
+esp_err_t sgp30_measure_raw_and_read(
+		sgp30_handle_t *sgp30         ,
+		uint16_t       *h2            ,
+		uint16_t       *ethanol       )
 {
 	esp_err_t ret;
 	uint16_t data[2];
 
-	ret = sgp30_i2c_read(
-		sgp30->i2c     ,
-		sgp30->address ,
-		data           ,
-		2              );
-
+	ret = sgp30_execute(sgp30, SGP30_CMD_MEASURE_RAW, NULL, data);
 	if (ret != ESP_OK)
-	{
-		ESP_LOGE(TAG, "Error reading after command 'get_feature_set'.");
 		return ret;
-	}
 
 	*h2      = data[0];
 	*ethanol = data[1];
@@ -603,101 +334,105 @@ static esp_err_t sgp30_read_measure_raw(
 	return ESP_OK;
 }
 
-esp_err_t sgp30_measure_raw_and_read(
+esp_err_t sgp30_get_tvoc_inceptive_baseline_and_read(
 		sgp30_handle_t *sgp30         ,
-		uint16_t       *h2            ,
-		uint16_t       *ethanol       )
+		uint16_t       *baseline      )
 {
-	esp_err_t ret;
-	ret = sgp30_measure_raw(sgp30);
-	if (ret != ESP_OK)
-		return ret;
-
-	sgp30_sleep_ms(SGP30_I2C_WAIT_MS_MEASURE_RAW);
-
-	ret = sgp30_read_measure_raw(sgp30, h2, ethanol);
-	if (ret != ESP_OK)
-		return ret;
+	return sgp30_execute(sgp30, SGP30_CMD_GET_TVOC_INCEPTIVE_BASELINE, NULL, baseline);
+}
 
-	return ESP_OK;
+esp_err_t sgp30_set_tvoc_baseline(
+		sgp30_handle_t *sgp30         ,
+		uint16_t        baseline      )
+{
+	return sgp30_execute(sgp30, SGP30_CMD_SET_TVOC_BASELINE, &baseline, NULL);
 }
 
-static esp_err_t sgp30_get_tvoc_inceptive_baseline(
-		sgp30_handle_t *sgp30 )
+esp_err_t sgp30_get_serial_id_and_read(
+		sgp30_handle_t *sgp30         ,
+		uint64_t       *serial        )
 {
 	esp_err_t ret;
+	uint16_t data[3];
 
-	ret = sgp30_i2c_send_command(
-		sgp30->i2c                                ,
-		sgp30->address                            ,
-		SGP30_I2C_CMD_GET_TVOC_INCEPTIVE_BASELINE );
+	ret = sgp30_execute(sgp30, SGP30_CMD_GET_SERIAL_ID, NULL, data);
 	if (ret != ESP_OK)
-	{
-		ESP_LOGE(TAG, "Error with command 'get_tvoc_inceptive_baseline'.");
 		return ret;
-	}
+
+	*serial = ( (uint64_t) data[0] << 32 ) |
+	          ( (uint64_t) data[1] << 16 ) |
+	          ( (uint64_t) data[2] );
 
 	return ESP_OK;
 }
 
-static esp_err_t sgp30_read_get_tvoc_inceptive_baseline(
-		sgp30_handle_t *sgp30    ,
-		uint16_t       *baseline )
-{
-	esp_err_t ret;
+// *** *** //
 
-	ret = sgp30_i2c_read(
-		sgp30->i2c     ,
-		sgp30->address ,
-		baseline       ,
-		1              );
 
-	if (ret != ESP_OK)
-	{
-		ESP_LOGE(TAG, "Error reading after command 'get_tvoc_inceptive_baseline'.");
-		return ret;
-	}
 
-	return ESP_OK;
+
+
+// ** SGP30 IDENTITY ** //
+
+static esp_err_t sgp30_timing_calibrate(
+		sgp30_handle_t *sgp30 )
+{
+	// CRC-protected response: corrupted reads are detected, not trusted
+	return app_i2c_calibrate(
+			sgp30->i2c                           ,
+			sgp30->address                       ,
+			SGP30_I2C_CRC8_INIT                  ,
+			&sgp30_cmds[SGP30_CMD_GET_SERIAL_ID] ,
+			NULL                                 );
 }
 
-esp_err_t sgp30_get_tvoc_inceptive_baseline_and_read(
-		sgp30_handle_t *sgp30         ,
-		uint16_t       *baseline      )
+static esp_err_t sgp30_identity_load(
+		sgp30_handle_t *sgp30 )
 {
 	esp_err_t ret;
-	ret = sgp30_get_tvoc_inceptive_baseline(sgp30);
+
+	ret = sgp30_get_serial_id_and_read(sgp30, &sgp30->serial);
 	if (ret != ESP_OK)
 		return ret;
 
-	sgp30_sleep_ms(SGP30_I2C_WAIT_MS_GET_TVOC_INCEPTIVE_BASELINE);
-
-	ret = sgp30_read_get_tvoc_inceptive_baseline(sgp30, baseline);
+	ret = sgp30_get_feature_set_and_read(sgp30, &sgp30->type, &sgp30->version);
 	if (ret != ESP_OK)
 		return ret;
 
+	sgp30->identity_valid = true;
+
+	ESP_LOGI(TAG,
+		"SGP30 serial 0x%04X%08X, product type %u version 0x%02X.",
+		(uint32_t) (sgp30->serial >> 32), (uint32_t) sgp30->serial,
+		sgp30->type, sgp30->version
+	);
+
 	return ESP_OK;
 }
 
-esp_err_t sgp30_set_tvoc_baseline(
+esp_err_t sgp30_get_identity(
 		sgp30_handle_t *sgp30         ,
-		uint16_t        baseline      )
+		uint64_t       *serial        ,
+		uint8_t        *type          ,
+		uint8_t        *version       )
 {
 	esp_err_t ret;
 
-	ret = sgp30_i2c_send_command_with_data(
-		sgp30->i2c                      ,
-		sgp30->address                  ,
-		SGP30_I2C_CMD_SET_TVOC_BASELINE ,
-		&baseline                       ,
-		1                               );
-	if (ret != ESP_OK)
+	if (!sgp30->identity_valid)
 	{
-		ESP_LOGE(TAG, "Error with command 'set_tvoc_baseline'.");
-		return ret;
+		ret = sgp30_identity_load(sgp30);
+		if (ret != ESP_OK)
+			return ret;
 	}
 
-	sgp30_sleep_ms(SGP30_I2C_WAIT_MS_SET_TVOC_BASELINE);
+	if (serial != NULL)
+		*serial = sgp30->serial;
+	if (type != NULL)
+		*type = sgp30->type;
+	if (version != NULL)
+		*version = sgp30->version;
 
 	return ESP_OK;
-}
\ No newline at end of file
+}
+
+// *** *** //
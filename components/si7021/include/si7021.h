@@ -4,9 +4,19 @@
 #include "app_i2c.h"
 #include "esp_err.h"
 
+#include <stdbool.h>
+
 
 // ** SI7021 HANDLE LOGIC ** //
 
+// Measurement resolution (user register bits AD), RH - temperature bits
+typedef enum {
+	SI7021_RESOLUTION_RH12_T14 = 0x00 , // default on reset
+	SI7021_RESOLUTION_RH8_T12  = 0x01 ,
+	SI7021_RESOLUTION_RH10_T13 = 0x02 ,
+	SI7021_RESOLUTION_RH11_T11 = 0x03 ,
+} si7021_resolution_t;
+
 typedef struct {
 	uint8_t   scl_gpio_pin;
 	uint8_t   sda_gpio_pin;
@@ -16,6 +26,17 @@ typedef struct {
 	char             *name ;
 	uint8_t           address;
 	app_i2c_handle_t *i2c;
+
+	// Shadow copies of the device registers, see si7021_set_user_register()
+	// and si7021_set_heater_register()
+	bool              registers_valid;
+	uint8_t           user_reg;
+	uint8_t           heater_reg;
+
+	// Device identity, read once, see si7021_get_identity()
+	bool              identity_valid;
+	uint64_t          serial;
+	uint8_t           fw_rev;
 } si7021_handle_t;
 
 /**
@@ -23,13 +44,19 @@ typedef struct {
  * 
  * Configuration options include SCL/SDA GPIO pins and handle name.
  * 
+ * The user and heater registers are read once into the handle shadow copies,
+ * and the serial number and firmware revision into the handle identity. If
+ * the sensor does not answer, they are loaded again on next use.
+ * 
  * Memory allocation! Handle should be deleted after use. See si7021_delete().
  * 
  * @param[in]  name   string with Si7021 name identification.
  * @param[in]  args   object with configuration parameters for Si7021 handle.
  * @param[out] si7021  handle generated with memory allocation.
  * 
- * @return ESP_OK on success, the produced error otherwise.
+ * @return ESP_OK on success.
+ * @return ESP_ERR_NOT_FOUND if no Si7021 answers on the bus.
+ * @return The produced error otherwise.
  */
 esp_err_t si7021_create(
 		char *name                   ,
@@ -46,6 +73,18 @@ esp_err_t si7021_create(
 esp_err_t si7021_delete(
 		si7021_handle_t *si7021 );
 
+/**
+ * @brief Checks that the Si7021 answers on its address (address-only
+ *        transaction, no command is sent).
+ * 
+ * @param[in]  si7021  handle for the Si7021 sensor.
+ * 
+ * @return ESP_OK if the device is present.
+ * @return APP_I2C_ERR_NACK_ADDR if it did not answer, the bus error otherwise.
+ */
+esp_err_t si7021_probe(
+		si7021_handle_t *si7021 );
+
 
 
 
@@ -60,6 +99,8 @@ esp_err_t si7021_delete(
  *        USER_REGISTER:   0b00111010 (0x3A)
  *        HEATER_REGISTER: 0b00000000 (0x00)
  * 
+ *        The handle register shadow copies are set to these same values.
+ * 
  * @param[in]  si7021  handle for the Si7021 sensor.
  * 
  * @return ESP_OK on success, the produced error otherwise.
@@ -140,6 +181,8 @@ esp_err_t si7021_measure_temperature_from_previous_rh_and_read(
  *        0 > Disabled (default on reset)
  *        1 > Enabled
  * 
+ *        The handle user register shadow is updated on success.
+ * 
  * @param[in]  si7021    handle for the Si7021 sensor.
  * @param[in]  user_reg  new value for the Si7021 user register.
  * 
@@ -180,6 +223,8 @@ esp_err_t si7021_get_user_register_and_read(
  *        .... > linear growth
  *        1111 > 94.20 mA
  * 
+ *        The handle heater register shadow is updated on success.
+ * 
  * @param[in]  si7021      handle for the Si7021 sensor.
  * @param[in]  heater_reg  new value for the Si7021 heater register.
  * 
@@ -264,10 +309,92 @@ esp_err_t si7021_get_firmware_revision_and_read(
 
 /**
  * @brief Sends 'measure_rh' and 'measure_temperature_from_previous_rh'
- *        commands sequentially and calculates the percent relative humidity
- *        and the Celsius temperature from the read measurement values.
+ *        commands sequentially and reads the raw measurement codes.
+ * 
+ * @param[in]   si7021       handle for the Si7021 sensor.
+ * @param[out]  rh           raw relative humidity code.
+ * @param[out]  temperature  raw temperature code.
+ * 
+ * @return ESP_OK on success, the produced error otherwise.
+ */
+esp_err_t si7021_measure_and_read_raw(
+		si7021_handle_t *si7021      ,
+		uint16_t        *rh          ,
+		uint16_t        *temperature );
+
+/**
+ * @brief Non-blocking split of si7021_measure_and_read_raw(): sends the
+ *        'measure_rh' command and returns the conversion time to wait before
+ *        calling si7021_measure_raw_read(), for the current resolution.
+ * 
+ * @param[in]   si7021   handle for the Si7021 sensor.
+ * @param[out]  wait_ms  time to wait before reading.
+ * 
+ * @return ESP_OK on success, the produced error otherwise.
+ */
+esp_err_t si7021_measure_raw_start(
+		si7021_handle_t *si7021  ,
+		uint16_t        *wait_ms );
+
+/**
+ * @brief Reads the raw relative humidity code of a conversion started with
+ *        si7021_measure_raw_start(), and the temperature code from that
+ *        same conversion.
+ */
+esp_err_t si7021_measure_raw_read(
+		si7021_handle_t *si7021      ,
+		uint16_t        *rh          ,
+		uint16_t        *temperature );
+
+/**
+ * @brief Converts a raw relative humidity code into 1/100 %RH units, using
+ *        integer multiply-shift arithmetic only.
+ * 
+ * @param[in]  rh  raw relative humidity code.
+ * 
+ * @return relative humidity in 1/100 %RH (may fall slightly out of 0..10000).
+ */
+static inline int16_t si7021_convert_rh_centi(
+		uint16_t rh )
+{
+	// 125 * code / 65536 - 6 (%RH), in 1/100 %RH units
+	return (int16_t) ( ( (12500 * (uint32_t) rh + 0x8000) >> 16 ) ) - 600;
+}
+
+/**
+ * @brief Converts a raw temperature code into 1/100 ºC units, using integer
+ *        multiply-shift arithmetic only.
+ * 
+ * @param[in]  temperature  raw temperature code.
+ * 
+ * @return temperature in 1/100 ºC.
+ */
+static inline int16_t si7021_convert_temperature_centi(
+		uint16_t temperature )
+{
+	// 175.72 * code / 65536 - 46.85 (ºC), in 1/100 ºC units
+	return (int16_t) ( ( (17572 * (uint32_t) temperature + 0x8000) >> 16 ) ) - 4685;
+}
+
+/**
+ * @brief Sends 'measure_rh' and 'measure_temperature_from_previous_rh'
+ *        commands sequentially and converts the read measurement values into
+ *        integer 1/100 %RH and 1/100 ºC units.
  * 
- *        The resulting values are in 'float' type.
+ * @param[in]   si7021         handle for the Si7021 sensor.
+ * @param[out]  rh_centi       relative humidity in 1/100 %RH.
+ * @param[out]  celsius_centi  temperature in 1/100 ºC.
+ * 
+ * @return ESP_OK on success, the produced error otherwise.
+ */
+esp_err_t si7021_measure_and_read_centi(
+		si7021_handle_t *si7021        ,
+		int16_t         *rh_centi      ,
+		int16_t         *celsius_centi );
+
+/**
+ * @brief Same as 'si7021_measure_and_read_centi()', with the resulting values
+ *        converted to 'float' %RH and ºC.
  * 
  * @param[in]   si7021      handle for the Si7021 sensor.
  * @param[out]  rh_percent  %RH value.
@@ -281,8 +408,12 @@ esp_err_t si7021_measure_and_read_converted(
 		float           *celsius    );
 
 /**
- * @brief Sends commands 'get_id_fst_access' and 'get_id_snd_access' to
- *        retrieve the Si7021 64bit serial number.
+ * @brief Retrieves the Si7021 64bit serial number (SNA_3 as most significant
+ *        byte) from the handle identity.
+ * 
+ *        The bus is only accessed ('get_id_fst_access', 'get_id_snd_access'
+ *        and 'get_firmware_revision') if the identity could not be read when
+ *        the handle was created.
  * 
  * @param[in]   si7021  handle for the Si7021 sensor.
  * @param[out]  serial  serial number for the Si7021 sensor.
@@ -293,7 +424,76 @@ esp_err_t si7021_get_serial_number(
 		si7021_handle_t *si7021 ,
 		uint64_t        *serial );
 
-// TODO
+/**
+ * @brief Retrieves the Si7021 serial number and firmware revision from the
+ *        handle identity, same as 'si7021_get_serial_number()'.
+ * 
+ * @param[in]   si7021  handle for the Si7021 sensor.
+ * @param[out]  serial  serial number (may be NULL).
+ * @param[out]  fw_rev  firmware revision, 0xFF for 1.0 and 0x20 for 2.0
+ *                      (may be NULL).
+ * 
+ * @return ESP_OK on success, the produced error otherwise.
+ */
+esp_err_t si7021_get_identity(
+		si7021_handle_t *si7021 ,
+		uint64_t        *serial ,
+		uint8_t         *fw_rev );
+
+/**
+ * @brief Enables the on-chip heater (user register bit C).
+ * 
+ *        Register updates are applied over the handle shadow copy: a single
+ *        'set_user_register' transaction is issued, or none if the bit is
+ *        already set.
+ * 
+ * @param[in]  si7021  handle for the Si7021 sensor.
+ * 
+ * @return ESP_OK on success, the produced error otherwise.
+ */
+esp_err_t si7021_heater_enable(
+		si7021_handle_t *si7021 );
+
+/**
+ * @brief Disables the on-chip heater (user register bit C). Same shadow
+ *        behaviour as 'si7021_heater_enable()'.
+ * 
+ * @param[in]  si7021  handle for the Si7021 sensor.
+ * 
+ * @return ESP_OK on success, the produced error otherwise.
+ */
+esp_err_t si7021_heater_disable(
+		si7021_handle_t *si7021 );
+
+/**
+ * @brief Sets the heater current (heater register bits ABCD, see
+ *        'si7021_set_heater_register()'). Skipped if unchanged.
+ * 
+ * @param[in]  si7021  handle for the Si7021 sensor.
+ * @param[in]  mA_val  4bit heater current code.
+ * 
+ * @return ESP_OK on success, the produced error otherwise.
+ */
+esp_err_t si7021_heater_set_current(
+		si7021_handle_t *si7021 ,
+		uint8_t          mA_val );
+
+/**
+ * @brief Sets the measurement resolution (user register bits AD, see
+ *        'si7021_set_user_register()'). Skipped if unchanged.
+ * 
+ *        Measurement wait times follow the resolution in the handle shadow,
+ *        see 'si7021_measure_raw_start()'.
+ * 
+ * @param[in]  si7021    handle for the Si7021 sensor.
+ * @param[in]  prec_val  2bit resolution code, 'AD' as bit 1 and bit 0 (see
+ *                       si7021_resolution_t).
+ * 
+ * @return ESP_OK on success, the produced error otherwise.
+ */
+esp_err_t si7021_set_measurement_precision(
+		si7021_handle_t *si7021   ,
+		uint8_t          prec_val );
 
 
 #endif
\ No newline at end of file
@@ -13,6 +13,18 @@ static const char *TAG = "Si7021";
 #define SI7021_I2C_SCL_PERIOD_MS  2
 #define SI7021_I2C_OP_DELAY_MS    (SI7021_I2C_SCL_PERIOD_MS / 2)
 
+#define SI7021_USER_REGISTER_RESET    0x3A
+#define SI7021_HEATER_REGISTER_RESET  0x00
+
+static esp_err_t si7021_registers_load(
+		si7021_handle_t *si7021 );
+
+static esp_err_t si7021_timing_calibrate(
+		si7021_handle_t *si7021 );
+
+static esp_err_t si7021_identity_load(
+		si7021_handle_t *si7021 );
+
 esp_err_t si7021_create(
 		char *name                   ,
 		si7021_config_args_t *args   ,
@@ -39,10 +51,11 @@ esp_err_t si7021_create(
 
 	ESP_LOGV(TAG, "Loading Si7021 I2C configuration.");
 	app_i2c_config_args_t i2c_args = {
-		.scl = args->scl_gpio_pin                 ,
-		.sda = args->sda_gpio_pin                 ,
-		.scl_period_ms = SI7021_I2C_SCL_PERIOD_MS ,
-		.op_delay_ms   = SI7021_I2C_OP_DELAY_MS   };
+		.scl            = args->scl_gpio_pin       ,
+		.sda            = args->sda_gpio_pin       ,
+		.scl_period_ms  = SI7021_I2C_SCL_PERIOD_MS ,
+		.op_delay_ms    = SI7021_I2C_OP_DELAY_MS   ,
+		.half_period_us = 0                        };
 
 	esp_err_t ret;
 	app_i2c_handle_t *i2c = malloc(sizeof(app_i2c_handle_t));
@@ -56,6 +69,42 @@ esp_err_t si7021_create(
 
 	si7021->i2c = i2c;
 
+	// Absent device: fail fast, before the identity reads and their retries
+	ret = si7021_probe(si7021);
+	if (ret != ESP_OK)
+	{
+		ESP_LOGW(TAG,
+			"No Si7021 answering at address 0x%02X (0x%X).",
+			si7021->address, ret
+		);
+
+		free(si7021->name);
+		app_i2c_delete(i2c);
+		free(i2c);
+
+		return ret == APP_I2C_ERR_NACK_ADDR ? ESP_ERR_NOT_FOUND : ret;
+	}
+
+	// Bus timing: calibrated once per deployment, then restored from NVS
+	if (app_i2c_timing_load(i2c) == ESP_ERR_NOT_FOUND &&
+		si7021_timing_calibrate(si7021) != ESP_OK )
+		ESP_LOGW(TAG, "Could not calibrate Si7021 I2C timing, using default.");
+
+	si7021->registers_valid = false;
+	si7021->user_reg        = SI7021_USER_REGISTER_RESET;
+	si7021->heater_reg      = SI7021_HEATER_REGISTER_RESET;
+
+	si7021->identity_valid  = false;
+	si7021->serial          = 0;
+	si7021->fw_rev          = 0;
+
+	// Not fatal: retried on next use
+	if (si7021_registers_load(si7021) != ESP_OK)
+		ESP_LOGW(TAG, "Could not load Si7021 registers, deferring.");
+
+	if (si7021_identity_load(si7021) != ESP_OK)
+		ESP_LOGW(TAG, "Could not load Si7021 identity, deferring.");
+
 	return ESP_OK;
 }
 
@@ -77,242 +126,125 @@ esp_err_t si7021_delete(
 	return ESP_OK;
 }
 
-// *** *** //
-
-
-
-
-
-// ** SI7021 I2C BASIC METHODS ** //
-
-#define SI7021_I2C_CRC8_POLY  0x31 // x^8 + x^5 + x^4 + 1
-#define SI7021_I2C_CRC8_INIT  0x00
-#define SI7021_I2C_CRC8_XOR   0x00
-
-static uint8_t crc8_checksum_calculate(
-		uint8_t  *bytes ,
-		uint16_t  count )
+esp_err_t si7021_probe(
+		si7021_handle_t *si7021 )
 {
-	ESP_LOGD(TAG, "Calculating CRC8 checksum for %d bytes.", count);
-
-	uint8_t crc8 = SI7021_I2C_CRC8_INIT;
-	uint16_t i, j;
-	for (i = 0; i < count; ++i)
-	{
-		crc8 ^= bytes[i];
-		for (j = 0; j < 8; ++j)
-		{
-			if (crc8 & 0x80)
-				crc8 = (crc8 << 1) ^ SI7021_I2C_CRC8_POLY;
-			else
-				crc8 = (crc8 << 1);
-		}
-		crc8 ^= SI7021_I2C_CRC8_XOR;
-	}
+	ESP_LOGD(TAG, "Probing Si7021 at address 0x%02X.", si7021->address);
 
-	return crc8;
+	return app_i2c_probe(si7021->i2c, si7021->address);
 }
 
-static void si7021_sleep_ms(
-		uint16_t ms )
-{
-	app_i2c_ll_sleep(ms);
-}
-
-static esp_err_t si7021_i2c_checksum_check(
-		uint8_t  *bytes    ,
-		uint16_t  count    ,
-		uint8_t   checksum )
-{
-	ESP_LOGD(TAG, "Checking checksum correctness.");
-
-	uint8_t crc8 = crc8_checksum_calculate(bytes, count);
-	if (crc8 != checksum)
-	{
-		ESP_LOGE(TAG, "Data checksum does not match with correspondant CRC8.");
-		return ESP_FAIL;
-	}
+// *** *** //
 
-	return ESP_OK;
-}
 
-static esp_err_t si7021_i2c_send_command(
-		app_i2c_handle_t *i2c     ,
-		uint8_t           address ,
-		uint8_t           command )
-{
-	ESP_LOGD(TAG, "Sending command to device.");
 
-	esp_err_t ret;
-	ret = app_i2c_write(i2c, address, &command, 1);
-	if (ret != ESP_OK)
-	{
-		ESP_LOGE(TAG,
-			"Error while sending command %X to device address %X.",
-			command,
-			address
-		);
-		return ret;
-	}
 
-	return ESP_OK;
-}
 
-static esp_err_t si7021_i2c_send_command_long(
-		app_i2c_handle_t *i2c     ,
-		uint8_t           address ,
-		uint16_t          command )
-{
-	ESP_LOGD(TAG, "Sending command to device.");
+// ** SI7021 COMMAND DESCRIPTORS ** //
 
-	uint16_t count = 2;
-	uint8_t  buf[count];
+#define SI7021_I2C_CRC8_INIT  0x00
 
-	buf[0] = (uint8_t) (command >> 8 );
-	buf[1] = (uint8_t) (command & 0x00FF);
+typedef enum {
+	SI7021_CMD_RESET                             ,
+	SI7021_CMD_MEASURE_RH                        ,
+	SI7021_CMD_MEASURE_TEMPERATURE               ,
+	SI7021_CMD_READ_TEMPERATURE_FROM_PREVIOUS_RH ,
+	SI7021_CMD_SET_USER_REGISTER                 ,
+	SI7021_CMD_GET_USER_REGISTER                 ,
+	SI7021_CMD_SET_HEATER_REGISTER               ,
+	SI7021_CMD_GET_HEATER_REGISTER               ,
+	SI7021_CMD_GET_ID_FST_ACCESS                 ,
+	SI7021_CMD_GET_ID_SND_ACCESS                 ,
+	SI7021_CMD_GET_FIRMWARE_REVISION             ,
+} si7021_cmd_id_t;
 
-	esp_err_t ret;
-	ret = app_i2c_write(i2c, address, buf, count);
-	if (ret != ESP_OK)
-	{
-		ESP_LOGE(TAG,
-			"Error while sending command %X to device address %X.",
-			command,
-			address
-		);
-		return ret;
-	}
+// unused commands (clock stretching instead of NACK if measurement not ready)
+// MEASURE_TEMPERATURE_HOLD 0xF3
+// MEASURE_RH_HOLD          0xF5
+
+// Measurement wait times are for the default resolution, see
+// si7021_measure_wait_ms
+static const app_i2c_cmd_t si7021_cmds[] = {
+	//                                                name                                   opcode  op w  arg wait resp  crc                                            retry budget
+	[SI7021_CMD_RESET]                             = { "reset"                               , 0xFE  , 1, 1, 0, 30, 0, APP_I2C_CRC_NONE                             , 1, 100 },
+	[SI7021_CMD_MEASURE_RH]                        = { "measure_rh"                          , 0xE5  , 1, 2, 0, 24, 1, APP_I2C_CRC_RESPONSE                         , 1,  50 },
+	[SI7021_CMD_MEASURE_TEMPERATURE]               = { "measure_temperature"                 , 0xE3  , 1, 2, 0, 22, 1, APP_I2C_CRC_RESPONSE                         , 1,  50 },
+	[SI7021_CMD_READ_TEMPERATURE_FROM_PREVIOUS_RH] = { "measure_temperature_from_previous_rh", 0xE0  , 1, 2, 0,  0, 1, APP_I2C_CRC_NONE                             , 2,  50 },
+	[SI7021_CMD_SET_USER_REGISTER]                 = { "set_user_register"                   , 0xE6  , 1, 1, 1, 10, 0, APP_I2C_CRC_NONE                             , 2, 100 },
+	[SI7021_CMD_GET_USER_REGISTER]                 = { "get_user_register"                   , 0xE7  , 1, 1, 0, 10, 1, APP_I2C_CRC_NONE                             , 2, 100 },
+	[SI7021_CMD_SET_HEATER_REGISTER]               = { "set_heater_register"                 , 0x51  , 1, 1, 1, 10, 0, APP_I2C_CRC_NONE                             , 2, 100 },
+	[SI7021_CMD_GET_HEATER_REGISTER]               = { "get_heater_register"                 , 0x11  , 1, 1, 0, 10, 1, APP_I2C_CRC_NONE                             , 2, 100 },
+	[SI7021_CMD_GET_ID_FST_ACCESS]                 = { "get_id_fst_access"                   , 0xFA0F, 2, 1, 0, 10, 4, APP_I2C_CRC_RESPONSE | APP_I2C_CRC_CUMULATIVE, 2, 100 },
+	[SI7021_CMD_GET_ID_SND_ACCESS]                 = { "get_id_snd_access"                   , 0xFCC9, 2, 2, 0, 10, 2, APP_I2C_CRC_RESPONSE | APP_I2C_CRC_CUMULATIVE, 2, 100 },
+	[SI7021_CMD_GET_FIRMWARE_REVISION]             = { "get_firmware_revision"               , 0x84B8, 2, 1, 0, 10, 1, APP_I2C_CRC_NONE                             , 2, 100 },
+};
+
+// Conversion times (datasheet maximum, 'measure_rh' includes the temperature
+// conversion), rounded up with margin. Indexed by si7021_resolution_t.
+static const struct {
+	uint16_t rh_ms          ;
+	uint16_t temperature_ms ;
+} si7021_measure_wait_ms[] = {
+	[SI7021_RESOLUTION_RH12_T14] = { 24, 22 }, // 12 + 10.8, 10.8 (doubled)
+	[SI7021_RESOLUTION_RH8_T12]  = {  8,  5 }, // 3.1 + 3.8, 3.8
+	[SI7021_RESOLUTION_RH10_T13] = { 12,  8 }, // 4.5 + 6.2, 6.2
+	[SI7021_RESOLUTION_RH11_T11] = { 11,  4 }, // 7 + 2.4, 2.4
+};
+
+static si7021_resolution_t si7021_resolution(
+		si7021_handle_t *si7021 )
+{
+	// Unknown register: reset default, the slowest one
+	if (!si7021->registers_valid)
+		return SI7021_RESOLUTION_RH12_T14;
 
-	return ESP_OK;
+	return ( (si7021->user_reg >> 6) & 0x02 ) | (si7021->user_reg & 0x01);
 }
 
-static esp_err_t si7021_i2c_send_command_with_data(
-		app_i2c_handle_t *i2c           ,
-		uint8_t           address       ,
-		uint8_t           command       ,
-		uint8_t          *data          ,
-		uint8_t           num_data      ,
-		uint8_t           checksum_flag )
+static app_i2c_cmd_t si7021_cmd(
+		si7021_handle_t *si7021 ,
+		si7021_cmd_id_t  id     )
 {
-	ESP_LOGD(TAG, "Sending command with args to device.");
-
-	uint16_t count = 1 + num_data;
-	if (checksum_flag)
-		count += num_data;
+	app_i2c_cmd_t cmd = si7021_cmds[id];
 
-	uint8_t  buf[count];
-	uint16_t i = 0;
-
-	buf[i++] = command;
-
-	uint16_t j;
-	for (j = 0; j < num_data; ++j)
-	{
-		buf[i++] = data[j];
-		if (checksum_flag)
-			buf[i++] = crc8_checksum_calculate(data + j, 1);
-	}
-
-	esp_err_t ret;
-	ret = app_i2c_write(i2c, address, buf, count);
-	if (ret != ESP_OK)
-	{
-		ESP_LOGE(TAG,
-			"Error while sending command with args %X to device address %X.",
-			command,
-			address
-		);
-		return ret;
-	}
+	if (id == SI7021_CMD_MEASURE_RH)
+		cmd.wait_ms = si7021_measure_wait_ms[si7021_resolution(si7021)].rh_ms;
+	else if (id == SI7021_CMD_MEASURE_TEMPERATURE)
+		cmd.wait_ms = si7021_measure_wait_ms[si7021_resolution(si7021)].temperature_ms;
 
-	return ESP_OK;
+	return cmd;
 }
 
-static esp_err_t si7021_i2c_read(
-		app_i2c_handle_t *i2c           ,
-		uint8_t           address       ,
-		uint8_t          *data          ,
-		uint8_t           num_data      ,
-		uint8_t           checksum_flag )
+static esp_err_t si7021_execute(
+		si7021_handle_t *si7021   ,
+		si7021_cmd_id_t  id       ,
+		const uint16_t  *args     ,
+		uint16_t        *response )
 {
-	ESP_LOGD(TAG, "Reading from device.");
-
-	uint16_t count = num_data;
-	if (checksum_flag)
-		count += num_data;
-	uint8_t buf[count];
-
-	esp_err_t ret;
-	ret = app_i2c_read(i2c, address, buf, count);
-	if (ret != ESP_OK)
-	{
-		ESP_LOGE(TAG,
-			"Error while reading from device address %X.",
-			address
-		);
-		return ret;
-	}
+	app_i2c_cmd_t cmd = si7021_cmd(si7021, id);
 
-	uint16_t j;
-	for (j = 0; j < num_data; ++j)
-	{
-		if (checksum_flag)
-		{
-			ret = si7021_i2c_checksum_check(&buf[j], 1, buf[j + 1]);
-			if (ret != ESP_OK)
-			{
-				ESP_LOGE(TAG, "Error in checksum of read data.");
-				return ret;
-			}
-		}
-
-		data[j] = buf[j];
-	}
-
-	return ESP_OK;
+	return app_i2c_cmd_execute(
+		si7021->i2c          ,
+		si7021->address      ,
+		SI7021_I2C_CRC8_INIT ,
+		&cmd                 ,
+		args                 ,
+		response             );
 }
 
-static esp_err_t si7021_i2c_read_long(
-		app_i2c_handle_t *i2c           ,
-		uint8_t           address       ,
-		uint16_t         *data          ,
-		uint16_t          num_data      ,
-		uint8_t           checksum_flag )
+static esp_err_t si7021_execute_byte(
+		si7021_handle_t *si7021   ,
+		si7021_cmd_id_t  id       ,
+		uint8_t         *response )
 {
-	ESP_LOGD(TAG, "Reading from device.");
-
-	uint16_t count = num_data * 2;
-	if (checksum_flag)
-		count += num_data;
-	uint8_t buf[count];
-
 	esp_err_t ret;
-	ret = app_i2c_read(i2c, address, buf, count);
+	uint16_t data;
+
+	ret = si7021_execute(si7021, id, NULL, &data);
 	if (ret != ESP_OK)
-	{
-		ESP_LOGE(TAG,
-			"Error while reading from device address %X.",
-			address
-		);
 		return ret;
-	}
 
-	uint16_t j;
-	for (j = 0; j < num_data; ++j)
-	{
-		if (checksum_flag)
-		{
-			uint8_t *data_buf = buf + 3*j;
-			ret = si7021_i2c_checksum_check(data_buf, 2, data_buf[2]);
-			if (ret != ESP_OK)
-			{
-				ESP_LOGE(TAG, "Error in checksum of read data.");
-				return ret;
-			}
-		}
-
-		data[j] = ( (uint16_t) buf[j] << 8) | ( (uint16_t) buf[j + 1] );
-	}
+	*response = (uint8_t) data;
 
 	return ESP_OK;
 }
@@ -325,88 +257,17 @@ static esp_err_t si7021_i2c_read_long(
 
 // ** SI7021 COMMAND METHODS ** //
 
-#define SI7021_I2C_CMD_RESET                              0xFE
-#define SI7021_I2C_CMD_MEASURE_RH                         0xE5
-#define SI7021_I2C_CMD_MEASURE_TEMPERATURE                0xE3
-#define SI7021_I2C_CMD_READ_TEMPERATURE_FROM_PREVIOUS_RH  0xE0
-#define SI7021_I2C_CMD_SET_USER_REGISTER                  0xE6
-#define SI7021_I2C_CMD_GET_USER_REGISTER                  0xE7
-#define SI7021_I2C_CMD_SET_HEATER_REGISTER                0x51
-#define SI7021_I2C_CMD_GET_HEATER_REGISTER                0x11
-#define SI7021_I2C_CMD_GET_ID_FST_ACCESS                  0xFA0F
-#define SI7021_I2C_CMD_GET_ID_SND_ACCESS                  0xFCC9
-#define SI7021_I2C_CMD_GET_FIRMWARE_REVISION              0x84B8
-
-// unused commands (clock stretching instead of NACK if measurement not ready)
-// #define SI7021_I2C_CMD_MEASURE_TEMPERATURE_HOLD 0xF3
-// #define SI7021_I2C_CMD_MEASURE_RH_HOLD 0xF5
-
-#define SI7021_I2C_WAIT_MS_RESET                  30 // 15 * 2
-#define SI7021_I2C_WAIT_MS_MEASURE_RH             24 // 12 * 2
-#define SI7021_I2C_WAIT_MS_MEASURE_TEMPERATURE    22 // 10.8 * 2
-#define SI7021_I2C_WAIT_MS_SET_USER_REGISTER      10
-#define SI7021_I2C_WAIT_MS_GET_USER_REGISTER      10
-#define SI7021_I2C_WAIT_MS_SET_HEATER_REGISTER    10
-#define SI7021_I2C_WAIT_MS_GET_HEATER_REGISTER    10
-#define SI7021_I2C_WAIT_MS_GET_ID_FST_ACCESS      10
-#define SI7021_I2C_WAIT_MS_GET_ID_SND_ACCESS      10
-#define SI7021_I2C_WAIT_MS_GET_FIRMWARE_REVISION  10
-
 esp_err_t si7021_reset(
 		si7021_handle_t *si7021 )
 {
 	esp_err_t ret;
-	ret = si7021_i2c_send_command(
-		si7021->i2c          ,
-		si7021->address      ,
-		SI7021_I2C_CMD_RESET );
-
-	if (ret != ESP_OK)
-	{
-		ESP_LOGE(TAG, "Error with command 'reset'.");
-		return ret;
-	}
-
-	si7021_sleep_ms(SI7021_I2C_WAIT_MS_RESET);
-
-	return ESP_OK;
-}
-
-static esp_err_t si7021_measure_rh(
-		si7021_handle_t *si7021 )
-{
-	esp_err_t ret;
-	ret = si7021_i2c_send_command(
-		si7021->i2c               ,
-		si7021->address           ,
-		SI7021_I2C_CMD_MEASURE_RH );
-
+	ret = si7021_execute(si7021, SI7021_CMD_RESET, NULL, NULL);
 	if (ret != ESP_OK)
-	{
-		ESP_LOGE(TAG, "Error with command 'measure_rh'.");
 		return ret;
-	}
 
-	return ESP_OK;
-}
-
-static esp_err_t si7021_read_measure_rh(
-		si7021_handle_t *si7021 ,
-		uint16_t        *rh     )
-{
-	esp_err_t ret;
-
-	ret = si7021_i2c_read_long(
-		si7021->i2c     ,
-		si7021->address ,
-		rh              ,
-		1               ,
-		1               );
-	if (ret != ESP_OK)
-	{
-		ESP_LOGE(TAG, "Error reading after command 'measure_iaq'.");
-		return ret;
-	}
+	si7021->user_reg        = SI7021_USER_REGISTER_RESET;
+	si7021->heater_reg      = SI7021_HEATER_REGISTER_RESET;
+	si7021->registers_valid = true;
 
 	return ESP_OK;
 }
@@ -415,627 +276,396 @@ esp_err_t si7021_measure_rh_and_read(
 		si7021_handle_t *si7021 ,
 		uint16_t        *rh     )
 {
-	esp_err_t ret;
-	ret = si7021_measure_rh(si7021);
-	if (ret != ESP_OK)
-		return ret;
-
-	si7021_sleep_ms(SI7021_I2C_WAIT_MS_MEASURE_RH);
-
-	ret = si7021_read_measure_rh(si7021, rh);
-	if (ret != ESP_OK)
-		return ret;
-
-	return ESP_OK;
+	return si7021_execute(si7021, SI7021_CMD_MEASURE_RH, NULL, rh);
 }
 
-static esp_err_t si7021_measure_temperature(
-		si7021_handle_t *si7021 )
+esp_err_t si7021_measure_temperature_and_read(
+		si7021_handle_t *si7021      ,
+		uint16_t        *temperature )
 {
-	esp_err_t ret;
-	ret = si7021_i2c_send_command(
-		si7021->i2c                        ,
-		si7021->address                    ,
-		SI7021_I2C_CMD_MEASURE_TEMPERATURE );
-
-	if (ret != ESP_OK)
-	{
-		ESP_LOGE(TAG, "Error with command 'measure_temperature'.");
-		return ret;
-	}
-
-	return ESP_OK;
+	return si7021_execute(si7021, SI7021_CMD_MEASURE_TEMPERATURE, NULL, temperature);
 }
 
-static esp_err_t si7021_read_measure_temperature(
+esp_err_t si7021_measure_temperature_from_previous_rh_and_read(
 		si7021_handle_t *si7021      ,
 		uint16_t        *temperature )
 {
-	esp_err_t ret;
-
-	ret = si7021_i2c_read_long(
-		si7021->i2c     ,
-		si7021->address ,
-		temperature     ,
-		1               ,
-		1               );
-	if (ret != ESP_OK)
-	{
-		ESP_LOGE(TAG, "Error reading after command 'measure_temperature'.");
-		return ret;
-	}
-
-	return ESP_OK;
+	return si7021_execute(si7021, SI7021_CMD_READ_TEMPERATURE_FROM_PREVIOUS_RH, NULL, temperature);
 }
 
-esp_err_t si7021_measure_temperature_and_read(
-		si7021_handle_t *si7021      ,
-		uint16_t        *temperature )
+esp_err_t si7021_set_user_register(
+		si7021_handle_t *si7021   ,
+		uint8_t          user_reg )
 {
 	esp_err_t ret;
-	ret = si7021_measure_temperature(si7021);
-	if (ret != ESP_OK)
-		return ret;
+	uint16_t data = user_reg;
 
-	si7021_sleep_ms(SI7021_I2C_WAIT_MS_MEASURE_TEMPERATURE);
-
-	ret = si7021_read_measure_temperature(si7021, temperature);
+	ret = si7021_execute(si7021, SI7021_CMD_SET_USER_REGISTER, &data, NULL);
 	if (ret != ESP_OK)
 		return ret;
 
+	si7021->user_reg = user_reg;
+
 	return ESP_OK;
 }
 
-static esp_err_t si7021_measure_temperature_from_previous_rh(
-		si7021_handle_t *si7021 )
+esp_err_t si7021_get_user_register_and_read(
+		si7021_handle_t *si7021   ,
+		uint8_t         *user_reg )
 {
 	esp_err_t ret;
-	ret = si7021_i2c_send_command(
-		si7021->i2c                                      ,
-		si7021->address                                  ,
-		SI7021_I2C_CMD_READ_TEMPERATURE_FROM_PREVIOUS_RH );
-
+	ret = si7021_execute_byte(si7021, SI7021_CMD_GET_USER_REGISTER, user_reg);
 	if (ret != ESP_OK)
-	{
-		ESP_LOGE(TAG, "Error with command 'measure_temperature_from_previous_rh'.");
 		return ret;
-	}
+
+	si7021->user_reg = *user_reg;
 
 	return ESP_OK;
 }
 
-static esp_err_t si7021_read_measure_temperature_from_previous_rh(
-		si7021_handle_t *si7021      ,
-		uint16_t        *temperature )
+esp_err_t si7021_set_heater_register(
+		si7021_handle_t *si7021     ,
+		uint8_t          heater_reg )
 {
 	esp_err_t ret;
+	uint16_t data = heater_reg;
 
-	ret = si7021_i2c_read_long(
-		si7021->i2c     ,
-		si7021->address ,
-		temperature     ,
-		1               ,
-		0               );
+	ret = si7021_execute(si7021, SI7021_CMD_SET_HEATER_REGISTER, &data, NULL);
 	if (ret != ESP_OK)
-	{
-		ESP_LOGE(TAG, "Error reading after command 'measure_temperature_from_previous_rh'.");
 		return ret;
-	}
+
+	si7021->heater_reg = heater_reg;
 
 	return ESP_OK;
 }
 
-esp_err_t si7021_measure_temperature_from_previous_rh_and_read(
-		si7021_handle_t *si7021      ,
-		uint16_t        *temperature )
+esp_err_t si7021_get_heater_register_and_read(
+		si7021_handle_t *si7021     ,
+		uint8_t         *heater_reg )
 {
 	esp_err_t ret;
-	ret = si7021_measure_temperature_from_previous_rh(si7021);
+	ret = si7021_execute_byte(si7021, SI7021_CMD_GET_HEATER_REGISTER, heater_reg);
 	if (ret != ESP_OK)
 		return ret;
 
-	// no wait time
-
-	ret = si7021_read_measure_temperature_from_previous_rh(si7021, temperature);
-	if (ret != ESP_OK)
-		return ret;
+	si7021->heater_reg = *heater_reg;
 
 	return ESP_OK;
 }
 
-esp_err_t si7021_set_user_register(
-		si7021_handle_t *si7021   ,
-		uint8_t          user_reg )
+esp_err_t si7021_get_id_fst_access_and_read(
+		si7021_handle_t *si7021 ,
+		uint8_t         *sna3   ,
+		uint8_t         *sna2   ,
+		uint8_t         *sna1   ,
+		uint8_t         *sna0   )
 {
 	esp_err_t ret;
+	uint16_t data[4];
 
-	ret = si7021_i2c_send_command_with_data(
-		si7021->i2c                        ,
-		si7021->address                    ,
-		SI7021_I2C_CMD_SET_USER_REGISTER   ,
-		&user_reg                          ,
-		1                                  ,
-		0                                  );
+	ret = si7021_execute(si7021, SI7021_CMD_GET_ID_FST_ACCESS, NULL, data);
 	if (ret != ESP_OK)
-	{
-		ESP_LOGE(TAG, "Error with command 'set_user_register'.");
 		return ret;
-	}
 
-	si7021_sleep_ms(SI7021_I2C_WAIT_MS_SET_USER_REGISTER);
+	*sna3 = (uint8_t) data[0];
+	*sna2 = (uint8_t) data[1];
+	*sna1 = (uint8_t) data[2];
+	*sna0 = (uint8_t) data[3];
 
 	return ESP_OK;
 }
 
-static esp_err_t si7021_get_user_register(
-		si7021_handle_t *si7021   )
+esp_err_t si7021_get_id_snd_access_and_read(
+		si7021_handle_t *si7021 ,
+		uint8_t         *snb3   ,
+		uint8_t         *snb2   ,
+		uint8_t         *snb1   ,
+		uint8_t         *snb0   )
 {
 	esp_err_t ret;
-	ret = si7021_i2c_send_command(
-		si7021->i2c                      ,
-		si7021->address                  ,
-		SI7021_I2C_CMD_GET_USER_REGISTER );
+	uint16_t data[2];
 
+	ret = si7021_execute(si7021, SI7021_CMD_GET_ID_SND_ACCESS, NULL, data);
 	if (ret != ESP_OK)
-	{
-		ESP_LOGE(TAG, "Error with command 'get_user_register'.");
 		return ret;
-	}
+
+	*snb3 = (uint8_t) ( (data[0] & 0xFF00) >> 8 );
+	*snb2 = (uint8_t) (data[0] & 0x00FF);
+	*snb1 = (uint8_t) ( (data[1] & 0xFF00) >> 8 );
+	*snb0 = (uint8_t) (data[1] & 0x00FF);
 
 	return ESP_OK;
 }
 
-static esp_err_t si7021_read_get_user_register(
-		si7021_handle_t *si7021   ,
-		uint8_t         *user_reg )
+esp_err_t si7021_get_firmware_revision_and_read(
+		si7021_handle_t *si7021 ,
+		uint8_t         *fw_rev )
 {
-	esp_err_t ret;
-
-	ret = si7021_i2c_read(
-		si7021->i2c     ,
-		si7021->address ,
-		user_reg        ,
-		1               ,
-		0               );
-	if (ret != ESP_OK)
-	{
-		ESP_LOGE(TAG, "Error reading after command 'get_user_register'.");
-		return ret;
-	}
-
-	return ESP_OK;
+	return si7021_execute_byte(si7021, SI7021_CMD_GET_FIRMWARE_REVISION, fw_rev);
 }
 
-esp_err_t si7021_get_user_register_and_read(
-		si7021_handle_t *si7021   ,
-		uint8_t         *user_reg )
-{
-	esp_err_t ret;
-	ret = si7021_get_user_register(si7021);
-	if (ret != ESP_OK)
-		return ret;
+// *** *** //
 
-	si7021_sleep_ms(SI7021_I2C_WAIT_MS_GET_USER_REGISTER);
 
-	ret = si7021_read_get_user_register(si7021, user_reg);
-	if (ret != ESP_OK)
-		return ret;
 
-	return ESP_OK;
-}
 
 
+// ** SI7021 ADVANCED METHODS ** //
 
-esp_err_t si7021_set_heater_register(
-		si7021_handle_t *si7021     ,
-		uint8_t          heater_reg )
+esp_err_t si7021_measure_and_read_raw(
+		si7021_handle_t *si7021      ,
+		uint16_t        *rh          ,
+		uint16_t        *temperature )
 {
 	esp_err_t ret;
 
-	ret = si7021_i2c_send_command_with_data(
-		si7021->i2c                        ,
-		si7021->address                    ,
-		SI7021_I2C_CMD_SET_HEATER_REGISTER ,
-		&heater_reg                        ,
-		1                                  ,
-		0                                  );
+	ret = si7021_measure_rh_and_read(si7021, rh);
 	if (ret != ESP_OK)
-	{
-		ESP_LOGE(TAG, "Error with command 'set_heater_register'.");
 		return ret;
-	}
-
-	si7021_sleep_ms(SI7021_I2C_WAIT_MS_SET_HEATER_REGISTER);
-
-	return ESP_OK;
-}
-
-static esp_err_t si7021_get_heater_register(
-		si7021_handle_t *si7021   )
-{
-	esp_err_t ret;
-	ret = si7021_i2c_send_command(
-		si7021->i2c                        ,
-		si7021->address                    ,
-		SI7021_I2C_CMD_GET_HEATER_REGISTER );
 
+	ret = si7021_measure_temperature_from_previous_rh_and_read(si7021, temperature);
 	if (ret != ESP_OK)
-	{
-		ESP_LOGE(TAG, "Error with command 'get_heater_register'.");
 		return ret;
-	}
 
 	return ESP_OK;
 }
 
-static esp_err_t si7021_read_get_heater_register(
-		si7021_handle_t *si7021     ,
-		uint8_t         *heater_reg )
+esp_err_t si7021_measure_raw_start(
+		si7021_handle_t *si7021  ,
+		uint16_t        *wait_ms )
 {
-	esp_err_t ret;
+	app_i2c_cmd_t cmd = si7021_cmd(si7021, SI7021_CMD_MEASURE_RH);
 
-	ret = si7021_i2c_read(
-		si7021->i2c     ,
-		si7021->address ,
-		heater_reg      ,
-		1               ,
-		0               );
-	if (ret != ESP_OK)
-	{
-		ESP_LOGE(TAG, "Error reading after command 'get_heater_register'.");
-		return ret;
-	}
+	*wait_ms = cmd.wait_ms;
 
-	return ESP_OK;
+	return app_i2c_cmd_send(si7021->i2c, si7021->address, SI7021_I2C_CRC8_INIT, &cmd, NULL);
 }
 
-esp_err_t si7021_get_heater_register_and_read(
-		si7021_handle_t *si7021     ,
-		uint8_t         *heater_reg )
+esp_err_t si7021_measure_raw_read(
+		si7021_handle_t *si7021      ,
+		uint16_t        *rh          ,
+		uint16_t        *temperature )
 {
 	esp_err_t ret;
-	ret = si7021_get_heater_register(si7021);
-	if (ret != ESP_OK)
-		return ret;
 
-	si7021_sleep_ms(SI7021_I2C_WAIT_MS_GET_HEATER_REGISTER);
-
-	ret = si7021_read_get_heater_register(si7021, heater_reg);
+	ret = app_i2c_cmd_read(
+		si7021->i2c                          ,
+		si7021->address                      ,
+		SI7021_I2C_CRC8_INIT                 ,
+		&si7021_cmds[SI7021_CMD_MEASURE_RH]  ,
+		rh                                   );
 	if (ret != ESP_OK)
 		return ret;
 
-	return ESP_OK;
-}
-
-static esp_err_t si7021_get_id_fst_access(
-		si7021_handle_t *si7021 )
-{
-	esp_err_t ret;
-	ret = si7021_i2c_send_command_long(
-		si7021->i2c                      ,
-		si7021->address                  ,
-		SI7021_I2C_CMD_GET_ID_FST_ACCESS );
-
+	ret = si7021_measure_temperature_from_previous_rh_and_read(si7021, temperature);
 	if (ret != ESP_OK)
-	{
-		ESP_LOGE(TAG, "Error with command 'get_id_fst_access'.");
 		return ret;
-	}
 
 	return ESP_OK;
 }
 
-static esp_err_t si7021_read_get_id_fst_access(
-		si7021_handle_t *si7021 ,
-		uint8_t         *sna3   ,
-		uint8_t         *sna2   ,
-		uint8_t         *sna1   ,
-		uint8_t         *sna0   )
+esp_err_t si7021_measure_and_read_centi(
+		si7021_handle_t *si7021        ,
+		int16_t         *rh_centi      ,
+		int16_t         *celsius_centi )
 {
 	esp_err_t ret;
 
-	uint8_t buf[4];
+	uint16_t rh;
+	uint16_t temperature;
 
-	ret = si7021_i2c_read(
-		si7021->i2c     ,
-		si7021->address ,
-		buf             ,
-		4               ,
-		1               );
+	ret = si7021_measure_and_read_raw(si7021, &rh, &temperature);
 	if (ret != ESP_OK)
-	{
-		ESP_LOGE(TAG, "Error reading after command 'get_id_fst_access'.");
 		return ret;
-	}
 
-	*sna3 = buf[0];
-	*sna2 = buf[1];
-	*sna1 = buf[2];
-	*sna0 = buf[3];
+	*rh_centi      = si7021_convert_rh_centi(rh);
+	*celsius_centi = si7021_convert_temperature_centi(temperature);
 
 	return ESP_OK;
 }
 
-esp_err_t si7021_get_id_fst_access_and_read(
-		si7021_handle_t *si7021 ,
-		uint8_t         *sna3   ,
-		uint8_t         *sna2   ,
-		uint8_t         *sna1   ,
-		uint8_t         *sna0   )
+esp_err_t si7021_measure_and_read_converted(
+		si7021_handle_t *si7021     ,
+		float           *rh_percent ,
+		float           *celsius    )
 {
 	esp_err_t ret;
-	ret = si7021_get_id_fst_access(si7021);
-	if (ret != ESP_OK)
-		return ret;
 
-	si7021_sleep_ms(SI7021_I2C_WAIT_MS_GET_ID_FST_ACCESS);
+	int16_t rh_centi;
+	int16_t celsius_centi;
 
-	ret = si7021_read_get_id_fst_access(si7021, sna3, sna2, sna1, sna0);
+	ret = si7021_measure_and_read_centi(si7021, &rh_centi, &celsius_centi);
 	if (ret != ESP_OK)
 		return ret;
 
+	*rh_percent = rh_centi      / 100.0f;
+	*celsius    = celsius_centi / 100.0f;
+
 	return ESP_OK;
 }
 
-static esp_err_t si7021_get_id_snd_access(
+static esp_err_t si7021_timing_calibrate(
 		si7021_handle_t *si7021 )
 {
-	esp_err_t ret;
-	ret = si7021_i2c_send_command_long(
-		si7021->i2c                      ,
-		si7021->address                  ,
-		SI7021_I2C_CMD_GET_ID_SND_ACCESS );
-
-	if (ret != ESP_OK)
-	{
-		ESP_LOGE(TAG, "Error with command 'get_id_snd_access'.");
-		return ret;
-	}
-
-	return ESP_OK;
+	// CRC-protected response: corrupted reads are detected, not trusted
+	return app_i2c_calibrate(
+			si7021->i2c                                ,
+			si7021->address                            ,
+			SI7021_I2C_CRC8_INIT                       ,
+			&si7021_cmds[SI7021_CMD_GET_ID_FST_ACCESS] ,
+			NULL                                       );
 }
 
-static esp_err_t si7021_read_get_id_snd_access(
-		si7021_handle_t *si7021 ,
-		uint8_t         *snb3   ,
-		uint8_t         *snb2   ,
-		uint8_t         *snb1   ,
-		uint8_t         *snb0   )
+static esp_err_t si7021_identity_load(
+		si7021_handle_t *si7021 )
 {
 	esp_err_t ret;
 
-	uint16_t buf[2];
+	uint8_t buf[8];
 
-	ret = si7021_i2c_read_long(
-		si7021->i2c     ,
-		si7021->address ,
-		buf             ,
-		2               ,
-		1               );
+	ret = si7021_get_id_fst_access_and_read(si7021, &buf[0], &buf[1], &buf[2], &buf[3]);
 	if (ret != ESP_OK)
-	{
-		ESP_LOGE(TAG, "Error reading after command 'get_id_snd_access'.");
 		return ret;
-	}
-
-	*snb3 = (uint8_t) ( (buf[0] & 0xFF00) >> 8 );
-	*snb2 = (uint8_t) (buf[0] & 0x00FF);
-	*snb1 = (uint8_t) ( (buf[1] & 0xFF00) >> 8 );
-	*snb0 = (uint8_t) (buf[1] & 0x00FF);
-
-	return ESP_OK;
-}
 
-esp_err_t si7021_get_id_snd_access_and_read(
-		si7021_handle_t *si7021 ,
-		uint8_t         *snb3   ,
-		uint8_t         *snb2   ,
-		uint8_t         *snb1   ,
-		uint8_t         *snb0   )
-{
-	esp_err_t ret;
-	ret = si7021_get_id_snd_access(si7021);
+	ret = si7021_get_id_snd_access_and_read(si7021, &buf[4], &buf[5], &buf[6], &buf[7]);
 	if (ret != ESP_OK)
 		return ret;
 
-	si7021_sleep_ms(SI7021_I2C_WAIT_MS_GET_ID_SND_ACCESS);
-
-	ret = si7021_read_get_id_snd_access(si7021, snb3, snb2, snb1, snb0);
+	ret = si7021_get_firmware_revision_and_read(si7021, &si7021->fw_rev);
 	if (ret != ESP_OK)
 		return ret;
 
-	return ESP_OK;
-}
+	si7021->serial = 0;
 
-static esp_err_t si7021_get_firmware_revision(
-		si7021_handle_t *si7021 )
-{
-	esp_err_t ret;
-	ret = si7021_i2c_send_command_long(
-		si7021->i2c                          ,
-		si7021->address                      ,
-		SI7021_I2C_CMD_GET_FIRMWARE_REVISION );
+	uint8_t i;
+	for (i = 0; i < 8; ++i)
+		si7021->serial |= ( (uint64_t) buf[i] ) << ( 8 * (7 - i) );
 
-	if (ret != ESP_OK)
-	{
-		ESP_LOGE(TAG, "Error with command 'get_firmware_revision'.");
-		return ret;
-	}
+	si7021->identity_valid = true;
+
+	ESP_LOGI(TAG,
+		"Si7021 serial 0x%08X%08X, firmware revision 0x%02X.",
+		(uint32_t) (si7021->serial >> 32), (uint32_t) si7021->serial,
+		si7021->fw_rev
+	);
 
 	return ESP_OK;
 }
 
-static esp_err_t si7021_read_get_firmware_revision(
+esp_err_t si7021_get_identity(
 		si7021_handle_t *si7021 ,
+		uint64_t        *serial ,
 		uint8_t         *fw_rev )
 {
 	esp_err_t ret;
 
-	ret = si7021_i2c_read(
-		si7021->i2c     ,
-		si7021->address ,
-		fw_rev          ,
-		1               ,
-		0               );
-	if (ret != ESP_OK)
+	if (!si7021->identity_valid)
 	{
-		ESP_LOGE(TAG, "Error reading after command 'get_firmware_revision'.");
-		return ret;
+		ret = si7021_identity_load(si7021);
+		if (ret != ESP_OK)
+			return ret;
 	}
 
+	if (serial != NULL)
+		*serial = si7021->serial;
+	if (fw_rev != NULL)
+		*fw_rev = si7021->fw_rev;
+
 	return ESP_OK;
 }
 
-esp_err_t si7021_get_firmware_revision_and_read(
+esp_err_t si7021_get_serial_number(
 		si7021_handle_t *si7021 ,
-		uint8_t         *fw_rev )
+		uint64_t        *serial )
 {
-	esp_err_t ret;
-	ret = si7021_get_firmware_revision(si7021);
-	if (ret != ESP_OK)
-		return ret;
-
-	si7021_sleep_ms(SI7021_I2C_WAIT_MS_GET_FIRMWARE_REVISION);
-
-	ret = si7021_read_get_firmware_revision(si7021, fw_rev);
-	if (ret != ESP_OK)
-		return ret;
-
-	return ESP_OK;
+	return si7021_get_identity(si7021, serial, NULL);
 }
 
-
-
-
-
-// ** SI7021 ADVANCED METHODS ** //
-
-esp_err_t si7021_measure_and_read_converted(
-		si7021_handle_t *si7021     ,
-		float           *rh_percent ,
-		float           *celsius    )
+static esp_err_t si7021_registers_load(
+		si7021_handle_t *si7021 )
 {
 	esp_err_t ret;
 
-	uint16_t rh;
-	uint16_t temperature;
-
-	ret = si7021_measure_rh_and_read(si7021, &rh);
+	uint8_t reg;
+	ret = si7021_get_user_register_and_read(si7021, &reg);
 	if (ret != ESP_OK)
 		return ret;
 
-	*rh_percent = ( (125 * (float) rh) / 65536 ) - 6;
-
-	ret = si7021_measure_temperature_from_previous_rh_and_read(si7021, &temperature);
+	ret = si7021_get_heater_register_and_read(si7021, &reg);
 	if (ret != ESP_OK)
 		return ret;
 
-	*celsius    = ( (175.72 * (float) temperature) / 65536 ) - 46.85;
+	si7021->registers_valid = true;
 
 	return ESP_OK;
 }
 
-esp_err_t si7021_get_serial_number(
+static esp_err_t si7021_user_register_update(
 		si7021_handle_t *si7021 ,
-		uint64_t        *serial )
+		uint8_t          mask   ,
+		uint8_t          value  )
 {
 	esp_err_t ret;
 
-	uint8_t buf[8];
-
-	ret = si7021_get_id_fst_access_and_read(si7021, &buf[0], &buf[1], &buf[2], &buf[3]);
-	if (ret != ESP_OK)
-		return ret;
-
-	ret = si7021_get_id_snd_access_and_read(si7021, &buf[4], &buf[5], &buf[6], &buf[7]);
-	if (ret != ESP_OK)
-		return ret;
-
-	*serial = 0;
+	if (!si7021->registers_valid)
+	{
+		ret = si7021_registers_load(si7021);
+		if (ret != ESP_OK)
+			return ret;
+	}
 
-	uint8_t i;
-	for (i = 0; i < 8; ++i)
-		*serial |= ( (uint64_t) buf[i] ) << (8 * i);
+	uint8_t user_reg = (si7021->user_reg & ~mask) | (value & mask);
+	if (user_reg == si7021->user_reg)
+		return ESP_OK;
 
-	return ESP_OK;
+	return si7021_set_user_register(si7021, user_reg);
 }
 
-esp_err_t si7021_heater_enable(
-		si7021_handle_t *si7021 )
+static esp_err_t si7021_heater_register_update(
+		si7021_handle_t *si7021 ,
+		uint8_t          mask   ,
+		uint8_t          value  )
 {
 	esp_err_t ret;
 
-	uint8_t user_reg;
-	ret = si7021_get_user_register_and_read(si7021, &user_reg);
-	if (ret != ESP_OK)
-		return ret;
+	if (!si7021->registers_valid)
+	{
+		ret = si7021_registers_load(si7021);
+		if (ret != ESP_OK)
+			return ret;
+	}
 
-	user_reg |= 0x04; // 0000 0100
+	uint8_t heater_reg = (si7021->heater_reg & ~mask) | (value & mask);
+	if (heater_reg == si7021->heater_reg)
+		return ESP_OK;
 
-	ret = si7021_set_user_register(si7021, user_reg);
-	if (ret != ESP_OK)
-		return ret;
+	return si7021_set_heater_register(si7021, heater_reg);
+}
 
-	return ESP_OK;
+esp_err_t si7021_heater_enable(
+		si7021_handle_t *si7021 )
+{
+	return si7021_user_register_update(si7021, 0x04, 0x04); // 0000 0100
 }
 
 esp_err_t si7021_heater_disable(
 		si7021_handle_t *si7021 )
 {
-	esp_err_t ret;
-
-	uint8_t user_reg;
-	ret = si7021_get_user_register_and_read(si7021, &user_reg);
-	if (ret != ESP_OK)
-		return ret;
-
-	user_reg &= 0xFB; // 1111 1011
-
-	ret = si7021_set_user_register(si7021, user_reg);
-	if (ret != ESP_OK)
-		return ret;
-
-	return ESP_OK;
+	return si7021_user_register_update(si7021, 0x04, 0x00); // 0000 0100
 }
 
 esp_err_t si7021_heater_set_current(
 		si7021_handle_t *si7021 ,
 		uint8_t          mA_val )
 {
-	esp_err_t ret;
-
-	uint8_t heater_reg;
-	ret = si7021_get_heater_register_and_read(si7021, &heater_reg);
-	if (ret != ESP_OK)
-		return ret;
-
-	heater_reg &= 0xF0;
-	heater_reg |= (mA_val & 0x0F);
-
-	ret = si7021_set_heater_register(si7021, heater_reg);
-	if (ret != ESP_OK)
-		return ret;
-
-	return ESP_OK;
+	return si7021_heater_register_update(si7021, 0x0F, mA_val);
 }
 
 esp_err_t si7021_set_measurement_precision(
 		si7021_handle_t *si7021   ,
 		uint8_t          prec_val )
 {
-	esp_err_t ret;
-
-	uint8_t user_reg;
-	ret = si7021_get_user_register_and_read(si7021, &user_reg);
-	if (ret != ESP_OK)
-		return ret;
-
-	user_reg &= 0x7E; // 0111 1110
-	user_reg |= ( (prec_val << 6) & 0x80 ) | (prec_val & 0x01);
+	uint8_t bits = ( (prec_val << 6) & 0x80 ) | (prec_val & 0x01);
 
-	ret = si7021_set_user_register(si7021, user_reg);
-	if (ret != ESP_OK)
-		return ret;
-
-	return ESP_OK;
-}
\ No newline at end of file
+	return si7021_user_register_update(si7021, 0x81, bits); // 1000 0001
+}
@@ -0,0 +1,103 @@
+#include "app_sensor_priv.h"
+
+#include "esp_timer.h"
+
+#include <stdio.h>
+#include <string.h>
+
+/* Cost of app_sensor_alert_evaluate() for tables of hundreds of rules, with
+ * channel values wandering across the thresholds so that rules raise and
+ * clear (callback included) as they would in the sensor task. */
+
+#define BENCH_SAMPLES   20000
+#define BENCH_MAX_RULES 1024
+
+static const uint16_t bench_rule_counts[] = { 16, 64, 256, 1024 };
+
+static app_sensor_alert_rule_t  rules[BENCH_MAX_RULES];
+static app_sensor_alert_state_t states[BENCH_MAX_RULES];
+
+static uint32_t callbacks;
+
+static void bench_callback(
+		uint16_t                       index  ,
+		const app_sensor_alert_rule_t *rule   ,
+		bool                           active ,
+		int32_t                        value  ,
+		void                          *arg    )
+{
+	callbacks++;
+}
+
+static uint32_t bench_random(void)
+{
+	static uint32_t x = 0x12345678;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	return x;
+}
+
+int main(void)
+{
+	uint16_t i;
+	for (i = 0; i < BENCH_MAX_RULES; ++i)
+	{
+		rules[i].channel         = (app_sensor_channel_t) (i % APP_SENSOR_CHANNEL_COUNT);
+		rules[i].comparison      = (i & 4) ? APP_SENSOR_ALERT_BELOW : APP_SENSOR_ALERT_ABOVE;
+		rules[i].threshold       = 400 + (int32_t) (bench_random() % 600);
+		rules[i].hysteresis      = (int32_t) (bench_random() % 50);
+		rules[i].min_duration_ms = (bench_random() % 4) * 1000;
+	}
+
+	uint8_t  c;
+	uint16_t r;
+	for (r = 0; r < sizeof(bench_rule_counts) / sizeof(bench_rule_counts[0]); ++r)
+	{
+		uint16_t count = bench_rule_counts[r];
+		memset(states, 0, sizeof(states));
+		callbacks = 0;
+
+		int32_t  values[APP_SENSOR_CHANNEL_COUNT] = { 700, 700, 700, 700 };
+		uint32_t transitions = 0;
+		uint32_t s;
+
+		int64_t start = esp_timer_get_time();
+		for (s = 0; s < BENCH_SAMPLES; ++s)
+		{
+			for (c = 0; c < APP_SENSOR_CHANNEL_COUNT; ++c)
+			{
+				values[c] += (int32_t) (bench_random() % 41) - 20;
+				if (values[c] < 300)  values[c] = 300;
+				if (values[c] > 1100) values[c] = 1100;
+			}
+
+			transitions += app_sensor_alert_evaluate(
+				rules                                ,
+				states                               ,
+				count                                ,
+				values                               ,
+				(1 << APP_SENSOR_CHANNEL_COUNT) - 1  ,
+				(TickType_t) s * 100                 , // 1 Hz samples
+				bench_callback                       ,
+				NULL                                 );
+		}
+		double elapsed_ns = (esp_timer_get_time() - start) * 1000.0;
+
+		printf("%4d rules: %8.1f ns per evaluation, %5.2f ns per rule, "
+			"%.2f transitions per sample\n",
+			count,
+			elapsed_ns / BENCH_SAMPLES,
+			elapsed_ns / BENCH_SAMPLES / count,
+			(double) transitions / BENCH_SAMPLES
+		);
+
+		if (transitions != callbacks)
+		{
+			printf("  FAIL %u transitions but %u callbacks\n", transitions, callbacks);
+			return 1;
+		}
+	}
+
+	return 0;
+}
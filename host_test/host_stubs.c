@@ -0,0 +1,98 @@
+#include "esp_err.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "nvs.h"
+
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <time.h>
+
+/* ESP-IDF services used by the components under test, reduced to what a
+ * single-threaded host process needs. */
+
+const char *esp_err_to_name(
+		esp_err_t code )
+{
+	static char name[16];
+	snprintf(name, sizeof(name), "0x%X", code);
+	return name;
+}
+
+void esp_log_write(
+		int         level  ,
+		const char *tag    ,
+		const char *format ,
+		...                )
+{
+	if (getenv("HOST_TEST_VERBOSE") == NULL)
+		return;
+
+	va_list args;
+	va_start(args, format);
+	fprintf(stderr, "%c (%s) ", "?EWIDV"[level], tag);
+	vfprintf(stderr, format, args);
+	fputc('\n', stderr);
+	va_end(args);
+}
+
+int64_t esp_timer_get_time(void)
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (int64_t) now.tv_sec * 1000000 + now.tv_nsec / 1000;
+}
+
+void vTaskDelay(
+		TickType_t ticks )
+{
+}
+
+BaseType_t xSemaphoreTake(
+		SemaphoreHandle_t semaphore ,
+		TickType_t        ticks     )
+{
+	return pdTRUE;
+}
+
+BaseType_t xSemaphoreGive(
+		SemaphoreHandle_t semaphore )
+{
+	return pdTRUE;
+}
+
+esp_err_t nvs_open(const char *name, nvs_open_mode_t mode, nvs_handle_t *handle)
+{
+	return ESP_ERR_NVS_NOT_FOUND;
+}
+
+esp_err_t nvs_get_u32(nvs_handle_t handle, const char *key, uint32_t *value)
+{
+	return ESP_ERR_NVS_NOT_FOUND;
+}
+
+esp_err_t nvs_get_i64(nvs_handle_t handle, const char *key, int64_t *value)
+{
+	return ESP_ERR_NVS_NOT_FOUND;
+}
+
+esp_err_t nvs_set_u32(nvs_handle_t handle, const char *key, uint32_t value)
+{
+	return ESP_ERR_NVS_NOT_FOUND;
+}
+
+esp_err_t nvs_set_i64(nvs_handle_t handle, const char *key, int64_t value)
+{
+	return ESP_ERR_NVS_NOT_FOUND;
+}
+
+esp_err_t nvs_commit(nvs_handle_t handle)
+{
+	return ESP_ERR_NVS_NOT_FOUND;
+}
+
+void nvs_close(nvs_handle_t handle)
+{
+}
@@ -0,0 +1,142 @@
+#include "sim_bus.h"
+
+#include "app_i2c.h"
+
+static struct {
+	bool     master_scl_low ;
+	bool     master_sda_low ;
+	uint8_t  slave_hold     ; // SCL pulses left before releasing SDA
+	uint32_t pulses         ;
+	uint32_t released_at    ;
+	uint32_t stops          ;
+} bus;
+
+static bool sim_bus_sda_level(void)
+{
+	return !bus.master_sda_low && bus.slave_hold == 0;
+}
+
+void sim_bus_reset(void)
+{
+	bus.master_scl_low = false;
+	bus.master_sda_low = false;
+	bus.slave_hold     = 0;
+	bus.pulses         = 0;
+	bus.released_at    = 0;
+	bus.stops          = 0;
+}
+
+void sim_bus_hold_sda(
+		uint8_t pulses )
+{
+	bus.slave_hold = pulses;
+}
+
+uint32_t sim_bus_scl_pulses(void)
+{
+	return bus.pulses;
+}
+
+uint32_t sim_bus_released_at(void)
+{
+	return bus.released_at;
+}
+
+uint32_t sim_bus_stops(void)
+{
+	return bus.stops;
+}
+
+bool sim_bus_sda_high(void)
+{
+	return sim_bus_sda_level();
+}
+
+
+/* app_i2c low-level layer */
+
+esp_err_t app_i2c_ll_init_pins(
+		uint8_t scl ,
+		uint8_t sda )
+{
+	sim_bus_reset();
+	return ESP_OK;
+}
+
+esp_err_t app_i2c_ll_release_pins(
+		uint8_t scl ,
+		uint8_t sda )
+{
+	return ESP_OK;
+}
+
+esp_err_t app_i2c_ll_SDA_in(
+		uint8_t sda )
+{
+	bool before = sim_bus_sda_level();
+	bus.master_sda_low = false;
+
+	if (!bus.master_scl_low && !before && sim_bus_sda_level())
+		bus.stops++;
+
+	return ESP_OK;
+}
+
+esp_err_t app_i2c_ll_SDA_out(
+		uint8_t sda )
+{
+	bus.master_sda_low = true;
+	return ESP_OK;
+}
+
+esp_err_t app_i2c_ll_SDA_read(
+		uint8_t  sda   ,
+		uint8_t *level )
+{
+	*level = sim_bus_sda_level();
+	return ESP_OK;
+}
+
+esp_err_t app_i2c_ll_SCL_in(
+		uint8_t scl )
+{
+	if (bus.master_scl_low)
+	{
+		bus.pulses++;
+
+		if (bus.slave_hold != 0 && bus.slave_hold != SIM_BUS_HOLD_FOREVER)
+		{
+			bus.slave_hold--;
+			if (bus.slave_hold == 0)
+				bus.released_at = bus.pulses;
+		}
+	}
+
+	bus.master_scl_low = false;
+	return ESP_OK;
+}
+
+esp_err_t app_i2c_ll_SCL_out(
+		uint8_t scl )
+{
+	bus.master_scl_low = true;
+	return ESP_OK;
+}
+
+esp_err_t app_i2c_ll_SCL_read(
+		uint8_t  scl   ,
+		uint8_t *level )
+{
+	*level = !bus.master_scl_low;
+	return ESP_OK;
+}
+
+void app_i2c_ll_sleep(
+		uint32_t ms )
+{
+}
+
+void app_i2c_ll_delay_us(
+		uint32_t us )
+{
+}
@@ -0,0 +1,46 @@
+#ifndef __SIM_BUS_H__
+#define __SIM_BUS_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Simulated open-drain I2C bus replacing the app_i2c low-level GPIO layer
+ * (app_i2c_ll_*): a line reads low if the master or the slave pulls it.
+ * The slave never stretches the clock and never ACKs. */
+
+#define SIM_BUS_HOLD_FOREVER 0xFF
+
+/**
+ * @brief Releases both lines and clears the slave state and counters.
+ */
+void sim_bus_reset(void);
+
+/**
+ * @brief Makes the slave hold SDA low for the next 'pulses' SCL clock pulses,
+ *        as a slave interrupted mid-byte does (SIM_BUS_HOLD_FOREVER: never
+ *        released).
+ */
+void sim_bus_hold_sda(
+		uint8_t pulses );
+
+/**
+ * @brief SCL clock pulses (rising edges) since the last reset.
+ */
+uint32_t sim_bus_scl_pulses(void);
+
+/**
+ * @brief SCL pulse count at which the slave released SDA (0 if it did not).
+ */
+uint32_t sim_bus_released_at(void);
+
+/**
+ * @brief STOP conditions (SDA rising while SCL high) since the last reset.
+ */
+uint32_t sim_bus_stops(void);
+
+/**
+ * @brief Current SDA line level.
+ */
+bool sim_bus_sda_high(void);
+
+#endif
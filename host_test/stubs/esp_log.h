@@ -0,0 +1,19 @@
+#ifndef __HOST_STUB_ESP_LOG_H__
+#define __HOST_STUB_ESP_LOG_H__
+
+#include "esp_err.h"
+
+// Printed only with HOST_TEST_VERBOSE set in the environment
+void esp_log_write(
+		int         level  ,
+		const char *tag    ,
+		const char *format ,
+		...                );
+
+#define ESP_LOGE(tag, format, ...) esp_log_write(1, tag, format, ##__VA_ARGS__)
+#define ESP_LOGW(tag, format, ...) esp_log_write(2, tag, format, ##__VA_ARGS__)
+#define ESP_LOGI(tag, format, ...) esp_log_write(3, tag, format, ##__VA_ARGS__)
+#define ESP_LOGD(tag, format, ...) esp_log_write(4, tag, format, ##__VA_ARGS__)
+#define ESP_LOGV(tag, format, ...) esp_log_write(5, tag, format, ##__VA_ARGS__)
+
+#endif
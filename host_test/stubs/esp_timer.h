@@ -0,0 +1,11 @@
+#ifndef __HOST_STUB_ESP_TIMER_H__
+#define __HOST_STUB_ESP_TIMER_H__
+
+#include "esp_err.h"
+
+typedef void *esp_timer_handle_t;
+
+// Monotonic host clock, in microseconds
+int64_t esp_timer_get_time(void);
+
+#endif
@@ -0,0 +1,19 @@
+#ifndef __HOST_STUB_FREERTOS_H__
+#define __HOST_STUB_FREERTOS_H__
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+typedef uint32_t TickType_t;
+typedef int      BaseType_t;
+typedef unsigned UBaseType_t;
+
+#define pdTRUE   1
+#define pdFALSE  0
+#define pdPASS   1
+
+#define portMAX_DELAY       0xFFFFFFFFu
+#define portTICK_PERIOD_MS  10
+
+#endif
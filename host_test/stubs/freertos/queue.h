@@ -0,0 +1,8 @@
+#ifndef __HOST_STUB_FREERTOS_QUEUE_H__
+#define __HOST_STUB_FREERTOS_QUEUE_H__
+
+#include "FreeRTOS.h"
+
+typedef void *QueueHandle_t;
+
+#endif
@@ -0,0 +1,12 @@
+#ifndef __HOST_STUB_FREERTOS_SEMPHR_H__
+#define __HOST_STUB_FREERTOS_SEMPHR_H__
+
+#include "queue.h"
+
+typedef void *SemaphoreHandle_t;
+
+// Always granted: host tests run single-threaded
+BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t ticks);
+BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore);
+
+#endif
@@ -0,0 +1,12 @@
+#ifndef __HOST_STUB_FREERTOS_TASK_H__
+#define __HOST_STUB_FREERTOS_TASK_H__
+
+#include "FreeRTOS.h"
+
+typedef void *TaskHandle_t;
+
+// Returns at once: host tests run single-threaded
+void vTaskDelay(
+		TickType_t ticks );
+
+#endif
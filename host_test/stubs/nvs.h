@@ -0,0 +1,24 @@
+#ifndef __HOST_STUB_NVS_H__
+#define __HOST_STUB_NVS_H__
+
+#include "esp_err.h"
+
+// Empty storage: every open or read reports ESP_ERR_NVS_NOT_FOUND
+#define ESP_ERR_NVS_NOT_FOUND  0x1102
+
+typedef uint32_t nvs_handle_t;
+
+typedef enum {
+	NVS_READONLY  ,
+	NVS_READWRITE ,
+} nvs_open_mode_t;
+
+esp_err_t nvs_open(const char *name, nvs_open_mode_t mode, nvs_handle_t *handle);
+esp_err_t nvs_get_u32(nvs_handle_t handle, const char *key, uint32_t *value);
+esp_err_t nvs_get_i64(nvs_handle_t handle, const char *key, int64_t *value);
+esp_err_t nvs_set_u32(nvs_handle_t handle, const char *key, uint32_t value);
+esp_err_t nvs_set_i64(nvs_handle_t handle, const char *key, int64_t value);
+esp_err_t nvs_commit(nvs_handle_t handle);
+void      nvs_close(nvs_handle_t handle);
+
+#endif
@@ -0,0 +1,139 @@
+#include "app_sensor.h"
+
+#include "esp_timer.h"
+
+#include <math.h>
+#include <stdio.h>
+
+/* Accuracy of the fixed-point absolute humidity kernel against the
+ * double-precision Magnus formula, over the Si7021 codes of -40...85 ºC and
+ * 0...100 %RH, and its cost against the former float/expf path. */
+
+#define CODE_STEP  4 // Si7021 codes: the 2 LSBs are status bits
+
+// Bound documented in app_sensor.h: 0.1 % + 1 LSB (1/256 g/m^3)
+#define TOLERANCE_RELATIVE  0.001
+#define TOLERANCE_LSB       1.0
+
+#define BENCH_ITERATIONS  10000000
+#define BENCH_INPUTS      4096 // power of 2
+
+static double celsius_of(
+		uint16_t code )
+{
+	return 175.72 * code / 65536.0 - 46.85;
+}
+
+static double rh_of(
+		uint16_t code )
+{
+	double rh = 125.0 * code / 65536.0 - 6.0;
+	return rh < 0.0 ? 0.0 : (rh > 100.0 ? 100.0 : rh);
+}
+
+// Saturation vapour density factor (g/m^3 per %RH), in 8.8 LSBs
+static double density_of(
+		double celsius )
+{
+	return 256.0 * 216.7 * 6.112 / 100.0
+		* exp(17.62 * celsius / (243.12 + celsius)) / (273.15 + celsius);
+}
+
+// Former sensor task path: single-precision formula and float to 8.8
+static uint16_t absolute_humidity_float(
+		float rh_percent ,
+		float celsius    )
+{
+	float ah = expf(17.62f * celsius / (243.12f + celsius));
+	ah = 216.7f * (rh_percent / 100.0f) * 6.112f * ah / (273.15f + celsius);
+
+	float intpart;
+	float fracpart = modff(ah, &intpart);
+	uint8_t ah_int  = intpart < 255.0f ? (uint8_t) intpart : 0xFF;
+	uint8_t ah_frac = fracpart > 0.0f ? (uint8_t) (256.0f * fracpart) : 0x00;
+	return ( (uint16_t) ah_int << 8 ) | ah_frac;
+}
+
+static double now_ns(void)
+{
+	return esp_timer_get_time() * 1000.0;
+}
+
+int main(void)
+{
+	uint32_t t_min = (uint32_t) ceil( (-40.0 + 46.85) * 65536.0 / 175.72 );
+	uint32_t t_max = (uint32_t) floor( ( 85.0 + 46.85) * 65536.0 / 175.72 );
+	uint32_t rh_min = (uint32_t) ceil( (  0.0 + 6.0) * 65536.0 / 125.0 );
+	uint32_t rh_max = (uint32_t) floor( (100.0 + 6.0) * 65536.0 / 125.0 );
+
+	t_min  = (t_min  + CODE_STEP - 1) / CODE_STEP * CODE_STEP;
+	rh_min = (rh_min + CODE_STEP - 1) / CODE_STEP * CODE_STEP;
+
+	uint64_t pairs    = 0;
+	uint64_t failures = 0;
+	double   worst    = 0.0; // error beyond the relative part, in LSBs
+
+	uint32_t t, rh;
+	for (t = t_min; t <= t_max; t += CODE_STEP)
+	{
+		double density = density_of(celsius_of(t));
+
+		for (rh = rh_min; rh <= rh_max; rh += CODE_STEP)
+		{
+			double reference = density * rh_of(rh);
+			if (reference > 65535.0)
+				reference = 65535.0;
+
+			double error = fabs(app_sensor_absolute_humidity(rh, t) - reference);
+			double excess = error - TOLERANCE_RELATIVE * reference;
+			if (excess > worst)
+				worst = excess;
+			if (excess > TOLERANCE_LSB)
+			{
+				if (failures++ < 10)
+					printf("  FAIL rh code %u, temperature code %u: %.2f LSB off\n",
+						rh, t, error);
+			}
+			pairs++;
+		}
+	}
+
+	printf("%llu code pairs: error within 0.1 %% + %.2f LSB\n",
+		(unsigned long long) pairs, worst);
+
+	// Cost per call, both paths over the same inputs (converted beforehand)
+	static uint16_t rh_codes[BENCH_INPUTS], t_codes[BENCH_INPUTS];
+	static float    rh_percent[BENCH_INPUTS], celsius[BENCH_INPUTS];
+	uint32_t i;
+	for (i = 0; i < BENCH_INPUTS; ++i)
+	{
+		rh_codes[i]   = rh_min + (i * 37 % (rh_max - rh_min));
+		t_codes[i]    = t_min  + (i * 53 % (t_max - t_min));
+		rh_percent[i] = (float) rh_of(rh_codes[i]);
+		celsius[i]    = (float) celsius_of(t_codes[i]);
+	}
+
+	volatile uint16_t sink;
+	double start;
+
+	start = now_ns();
+	for (i = 0; i < BENCH_ITERATIONS; ++i)
+		sink = app_sensor_absolute_humidity(
+			rh_codes[i & (BENCH_INPUTS - 1)] ,
+			t_codes[i & (BENCH_INPUTS - 1)]  );
+	double fixed_ns = (now_ns() - start) / BENCH_ITERATIONS;
+
+	start = now_ns();
+	for (i = 0; i < BENCH_ITERATIONS; ++i)
+		sink = absolute_humidity_float(
+			rh_percent[i & (BENCH_INPUTS - 1)] ,
+			celsius[i & (BENCH_INPUTS - 1)]    );
+	double float_ns = (now_ns() - start) / BENCH_ITERATIONS;
+	(void) sink;
+
+	printf("host cost: fixed-point %.1f ns, float/expf %.1f ns per call\n",
+		fixed_ns, float_ns);
+
+	printf("%s: %llu failure(s)\n", __FILE__, (unsigned long long) failures);
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,93 @@
+#include "app_i2c.h"
+#include "sim_bus.h"
+
+#include <stdio.h>
+#include <string.h>
+
+/* Stuck-SDA recovery at START (app_i2c_bus_recover()), exercised through
+ * app_i2c_probe() on the simulated bus. */
+
+#define TEST_ADDRESS 0x40
+
+static int failures = 0;
+
+#define CHECK(cond)                                                    \
+	do {                                                               \
+		if (!(cond)) {                                                 \
+			printf("  FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond);   \
+			failures++;                                                \
+		}                                                              \
+	} while (0)
+
+static void test_idle_bus(
+		app_i2c_handle_t *i2c )
+{
+	printf("idle bus: no recovery\n");
+	sim_bus_reset();
+	memset(&i2c->stats, 0, sizeof(i2c->stats));
+
+	CHECK(app_i2c_probe(i2c, TEST_ADDRESS) == APP_I2C_ERR_NACK_ADDR);
+	CHECK(i2c->stats.recoveries == 0);
+	CHECK(sim_bus_scl_pulses() == 10); // address byte, ACK bit, SCL rise of STOP
+	CHECK(sim_bus_sda_high());
+}
+
+static void test_released_after(
+		app_i2c_handle_t *i2c    ,
+		uint8_t           pulses )
+{
+	printf("SDA held for %d pulses: recovered\n", pulses);
+	sim_bus_reset();
+	memset(&i2c->stats, 0, sizeof(i2c->stats));
+	sim_bus_hold_sda(pulses);
+
+	// Transaction goes on after the recovery (no device ACKs on this bus)
+	CHECK(app_i2c_probe(i2c, TEST_ADDRESS) == APP_I2C_ERR_NACK_ADDR);
+	CHECK(sim_bus_released_at() == pulses);
+	CHECK(sim_bus_scl_pulses() == pulses + 10u);
+	CHECK(sim_bus_stops() >= 1);
+	CHECK(sim_bus_sda_high());
+	CHECK(i2c->stats.recoveries == 1);
+	CHECK(i2c->stats.recovery_failures == 0);
+}
+
+static void test_stuck_forever(
+		app_i2c_handle_t *i2c )
+{
+	printf("SDA held forever: bus stuck after 9 pulses\n");
+	sim_bus_reset();
+	memset(&i2c->stats, 0, sizeof(i2c->stats));
+	sim_bus_hold_sda(SIM_BUS_HOLD_FOREVER);
+
+	CHECK(app_i2c_probe(i2c, TEST_ADDRESS) == APP_I2C_ERR_BUS_STUCK);
+	CHECK(sim_bus_scl_pulses() == 9);
+	CHECK(!sim_bus_sda_high());
+	CHECK(i2c->stats.recoveries == 1);
+	CHECK(i2c->stats.recovery_failures == 1);
+}
+
+int main(void)
+{
+	app_i2c_config_args_t args = {
+		.scl            = 1 ,
+		.sda            = 2 ,
+		.scl_period_ms  = 2 ,
+		.op_delay_ms    = 1 ,
+		.half_period_us = 0 };
+
+	app_i2c_handle_t i2c;
+	app_i2c_create("sim_i2c", &args, &i2c);
+
+	test_idle_bus(&i2c);
+
+	uint8_t pulses;
+	for (pulses = 1; pulses <= 9; ++pulses)
+		test_released_after(&i2c, pulses);
+
+	test_stuck_forever(&i2c);
+
+	app_i2c_delete(&i2c);
+
+	printf("%s: %d failure(s)\n", __FILE__, failures);
+	return failures ? 1 : 0;
+}
@@ -4,6 +4,10 @@
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "nvs_flash.h"
+#include "esp_netif.h"
+#include "esp_event.h"
+#include "esp_sntp.h"
+#include "protocol_examples_common.h"
 
 #include "sgp30.h"
 #include "si7021.h"
@@ -13,6 +17,40 @@
 
 const char *TAG = "APP";
 
+// Wall clock for the age of the stored SGP30 baseline
+#define APP_SNTP_SERVER          "pool.ntp.org"
+#define APP_SNTP_TIMEOUT_MS      15000
+#define APP_SNTP_POLL_MS         100
+
+static void app_time_sync(void)
+{
+	esp_netif_init();
+	esp_event_loop_create_default();
+	if (example_connect() != ESP_OK)
+	{
+		ESP_LOGW(TAG, "No network: wall clock not synchronized.");
+		return;
+	}
+
+	// Keeps polling in the background if the first sync is late
+	sntp_setoperatingmode(SNTP_OPMODE_POLL);
+	sntp_setservername(0, APP_SNTP_SERVER);
+	sntp_init();
+
+	int waited_ms;
+	for (waited_ms = 0; waited_ms < APP_SNTP_TIMEOUT_MS; waited_ms += APP_SNTP_POLL_MS)
+	{
+		if (sntp_get_sync_status() == SNTP_SYNC_STATUS_COMPLETED)
+		{
+			ESP_LOGI(TAG, "Wall clock synchronized.");
+			return;
+		}
+		vTaskDelay(APP_SNTP_POLL_MS / portTICK_PERIOD_MS);
+	}
+
+	ESP_LOGW(TAG, "Wall clock not synchronized after %d ms.", APP_SNTP_TIMEOUT_MS);
+}
+
 
 /*
 static const uint8_t _hours = 20;
@@ -209,29 +247,36 @@ static void initialize_sgp30_baseline()
 void app_main(void)
 {
 	nvs_flash_init();
+
+	// Before the sensor init: a stored baseline is only restored with a known age
+	app_time_sync();
+
 	app_sensor_handle_t sensor;
 	app_sensor_init(&sensor);
 
-	app_sensor_start(&sensor);
+	// Woken by the sensor task on every new sample frame
+	app_sensor_subscribe_task(&sensor, xTaskGetCurrentTaskHandle(), 1, NULL);
 
-	uint16_t tvoc_ppb, co2eq_ppm;
-	float rh_percent = 0.0f;
-	float celsius = 0.0f;
+	app_sensor_start(&sensor);
 
-	vTaskDelay(1000 / portTICK_PERIOD_MS);
+	app_sensor_frame_t frame;
 
 	for (int m = 0; m < 2; ++m)
 		for (int s = 0; s < 60; ++s)
 		{
-			app_sensor_read_tvoc(&sensor, &tvoc_ppb);
-			app_sensor_read_co2eq(&sensor, &co2eq_ppm);
-			app_sensor_read_rh(&sensor, &rh_percent);
-			app_sensor_read_temperature(&sensor, &celsius);
+			if (ulTaskNotifyTake(pdTRUE, 2000 / portTICK_PERIOD_MS) == 0)
+			{
+				ESP_LOGW(TAG, "No sample frame received in time.");
+				continue;
+			}
 
-			ESP_LOGI(TAG, "TVOC: %d ppb\tCO2: %d ppm\tRH: %.2f %%\tºC: %.2f",
-				tvoc_ppb, co2eq_ppm, rh_percent, celsius);
+			if (app_sensor_read_frame(&sensor, &frame) != ESP_OK)
+				continue;
 
-			vTaskDelay(1000 / portTICK_PERIOD_MS);
+			ESP_LOGI(TAG, "TVOC: %d ppb\tCO2: %d ppm\tRH: %.2f %%\tºC: %.2f%s",
+				frame.tvoc_ppb, frame.co2eq_ppm,
+				frame.rh_centi / 100.0f, frame.celsius_centi / 100.0f,
+				frame.validity == APP_SENSOR_VALIDITY_EARLY ? "\t(early phase)" : "");
 		}
 	app_sensor_stop(&sensor);
 	app_sensor_delete(&sensor);